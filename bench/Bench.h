@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal microbenchmark harness, just enough to compare variants of the same kernel.
+namespace rt::bench {
+  // Keeps the compiler from optimizing away the computation of `value`
+  template <typename T> inline void DoNotOptimize(T const &value) { asm volatile("" : : "r"(&value) : "memory"); }
+
+  struct Result {
+    std::string name;
+    double      nsPerOp;
+  };
+
+  // Calls `fn` (which performs `opsPerCall` operations per call) repeatedly for at least
+  // `minSeconds`, `repetitions` times, and keeps the fastest repetition.
+  template <typename F>
+  Result Run(std::string name, long opsPerCall, F &&fn, int repetitions = 5, double minSeconds = 0.2) {
+    using clock = std::chrono::steady_clock;
+
+    // Warm up caches and branch predictors
+    fn();
+
+    double best = 1e300;
+    for (int r = 0; r < repetitions; r++) {
+      long       calls = 0;
+      auto const start = clock::now();
+      double     elapsed;
+
+      do {
+        fn();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+      } while (elapsed < minSeconds);
+
+      best = std::min(best, elapsed * 1e9 / (double(calls) * opsPerCall));
+    }
+
+    return {std::move(name), best};
+  }
+
+  inline void Print(std::string const &title, std::vector<Result> const &results) {
+    std::printf("%s\n", title.c_str());
+
+    for (auto const &result : results) {
+      std::printf("  %-40s %10.2f ns/op %10.2f Mop/s\n", result.name.c_str(), result.nsPerOp, 1e3 / result.nsPerOp);
+    }
+  }
+} // namespace rt::bench
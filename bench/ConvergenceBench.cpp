@@ -0,0 +1,194 @@
+#include "SceneRuns.h"
+
+#include "output/Checkpoint.h"
+#include "output/ImageError.h"
+#include "output/ImageOutput.h"
+
+#include <argumentum/argparse.h>
+#include <raylib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Renders a scene at 1, 2, 4, ... samples per pixel with each sampling configuration it
+// supports and reports, as CSV, the render time and error against a high sample count
+// reference. Plotting error over time gives each configuration's convergence curve, so
+// sampling changes can be compared at equal time rather than equal samples.
+//
+// The reference is rendered with another seed on the first run and cached in the cache
+// directory, keyed by the scene's hash. Delete it to render it again.
+//
+// Usage: convergence_bench [--width N] [--reference-spp N] [--max-spp N] [--budget SECONDS]
+//                          [--threads N] [--seed N] [--cache-dir DIR] [--output results.csv]
+//                          [scene.json]
+// Renders the first built-in scene without a scene file.
+
+using namespace rt;
+using namespace rt::bench;
+using namespace argumentum;
+
+namespace {
+  struct Options {
+    int         width        = 128;
+    int         referenceSpp = 1024;
+    int         maxSpp       = 256;
+    double      budget       = 0; // Seconds per configuration, no limit if 0
+    int         threads      = int(std::max(1u, std::thread::hardware_concurrency()));
+    int         seed         = 0;
+    std::string cacheDir     = "convergence-cache";
+    std::string output;
+    std::string sceneFile;
+  };
+
+  struct Config {
+    char const *name;
+    bool        sampleEnvironment;
+  };
+
+  struct Point {
+    char const *config;
+    int         spp;
+    double      timeMs;
+    ImageError  error;
+  };
+
+  std::optional<OutputImage> LoadOrRenderReference(Scene &scene, AsyncRenderData &ard, RenderPool &pool,
+                                                   Options const &options) {
+    RaytraceSettings const settings = scene.settings;
+
+    // Another seed than the measured renders, so their noise isn't correlated with the reference's
+    scene.settings.samplesPerPixel = options.referenceSpp;
+    scene.settings.seed            = options.seed + 1;
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.pfm", static_cast<unsigned long long>(SceneHash(scene)));
+    std::string const path = (std::filesystem::path(options.cacheDir) / name).string();
+
+    std::optional<OutputImage> reference = ReadPFM(path);
+    if (reference) {
+      std::cerr << "Using the cached reference " << path << '\n';
+    } else {
+      std::cerr << "Rendering the reference at " << options.referenceSpp << " spp\n";
+      double const ms = RenderOnce(scene, ard, pool);
+      std::cerr << "Reference took " << ms / 1000 << " s\n";
+
+      reference = Snapshot(ard.frameBuffer);
+      std::error_code error;
+      std::filesystem::create_directories(options.cacheDir, error);
+      if (!WritePFM(path, *reference))
+        std::cerr << "Failed to cache the reference in " << path << '\n';
+    }
+
+    scene.settings = settings;
+    return reference;
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+
+  Options         options;
+  argument_parser parser;
+
+  parser.config().program(argv[0]).description(
+      "Measures the error of a scene's renders at increasing sample counts against a reference");
+  parser.add_argument(options.width, "--width").maxargs(1).absent(options.width).help("Image width and height");
+  parser.add_argument(options.referenceSpp, "--reference-spp")
+      .maxargs(1)
+      .absent(options.referenceSpp)
+      .help("Samples per pixel of the reference");
+  parser.add_argument(options.maxSpp, "--max-spp")
+      .maxargs(1)
+      .absent(options.maxSpp)
+      .help("Most samples per pixel to measure");
+  parser.add_argument(options.budget, "--budget")
+      .maxargs(1)
+      .absent(options.budget)
+      .help("Stop a configuration's curve once a render takes longer than this many seconds");
+  parser.add_argument(options.threads, "--threads")
+      .maxargs(1)
+      .absent(options.threads)
+      .help("Threads to render with, all hardware threads by default");
+  parser.add_argument(options.seed, "--seed").maxargs(1).absent(options.seed).help("Seed of the measured renders");
+  parser.add_argument(options.cacheDir, "--cache-dir")
+      .maxargs(1)
+      .absent(options.cacheDir)
+      .help("Directory the references are cached in");
+  parser.add_argument(options.output, "--output").maxargs(1).absent("").help("Write the results here instead of stdout");
+  parser.add_argument(options.sceneFile, "scene").minargs(0).maxargs(1).absent("").help("Scene file to render");
+
+  if (!parser.parse_args(argc, argv, 1))
+    return 1;
+
+  options.threads = std::max(options.threads, 1);
+  int const size  = options.width;
+
+  StdoutToStderr logs;
+
+  Scene scene = options.sceneFile.empty() ? Scene::builtInScenes.front().second(size, size)
+                                          : Scene::Load(size, size, options.sceneFile);
+  std::string const sceneName = options.sceneFile.empty() ? Scene::builtInScenes.front().first : options.sceneFile;
+
+  // What `App::changeNumThreads` does, without the app's window
+  AsyncRenderData ard(size, size, size, size, options.threads);
+  RenderPool      pool(options.threads);
+  ard.changeNumThreads(options.threads, pool.numNodes());
+  ard.setTraversalOrder(scene.settings.traversalOrder);
+
+  auto const reference = LoadOrRenderReference(scene, ard, pool, options);
+
+  // Environment sampling is the only sampling strategy there's a switch for, and only matters
+  // with an environment map
+  std::vector<Config> configs = {{"bsdf", false}};
+  if (scene.environment)
+    configs.push_back({"environment MIS", true});
+
+  std::vector<Point> points;
+  for (auto const &config : configs) {
+    scene.settings.sampleEnvironment = config.sampleEnvironment;
+    scene.settings.seed              = options.seed;
+
+    for (int spp = 1; spp <= options.maxSpp; spp *= 2) {
+      scene.settings.samplesPerPixel = spp;
+      std::cerr << "Rendering " << config.name << " at " << spp << " spp\n";
+
+      double const ms    = RenderOnce(scene, ard, pool);
+      auto const   error = CompareImages(Snapshot(ard.frameBuffer), *reference);
+      if (!error) {
+        std::cerr << "The reference doesn't match the render's size\n";
+        return 1;
+      }
+
+      points.push_back({config.name, spp, ms, *error});
+      if (options.budget > 0 && ms > options.budget * 1000)
+        break;
+    }
+  }
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+    if (!file) {
+      std::cerr << "Failed to write " << options.output << '\n';
+      return 1;
+    }
+  }
+
+  std::ostream &out = options.output.empty() ? logs.results : file;
+  out << "scene,config,spp,time_ms,rmse,relmse,flip_like\n";
+
+  for (auto const &point : points) {
+    char line[256];
+    std::snprintf(line, sizeof(line), ",%s,%d,%.2f,%.6g,%.6g,%.6g\n", point.config, point.spp, point.timeMs,
+                  point.error.rmse, point.error.relMse, point.error.flipLike);
+    out << '"' << sceneName << '"' << line;
+  }
+
+  return out ? 0 : 1;
+}
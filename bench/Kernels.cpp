@@ -0,0 +1,139 @@
+#include "Bench.h"
+
+#include "AABB.h"
+#include "Perlin.h"
+#include "Ray.h"
+#include "Transformation.h"
+#include "Util.h"
+#include "objects/AARect.h"
+#include "objects/Sphere.h"
+#include "objects/Triangle.h"
+
+#include <raylib.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+// Times the primitive kernels renders spend most of their time in, each on its own over a
+// fixed batch of inputs, so a change to one of them can be measured without a full render.
+//
+// Usage: kernel_bench
+// Rays start in a box in front of the origin and aim at points around it, so they both hit and
+// miss the primitives, which sit at the origin with a size of about 1.
+
+using namespace rt;
+
+namespace {
+  const long batchSize = 1 << 14;
+
+  std::mt19937 &Rng() {
+    static std::mt19937 rng(1234);
+    return rng;
+  }
+
+  vec3 RandomPoint(float extent) {
+    std::uniform_real_distribution<float> dist(-extent, extent);
+    return vec3(dist(Rng()), dist(Rng()), dist(Rng()));
+  }
+
+  std::vector<rt::Ray> RayBatch() {
+    std::vector<rt::Ray> rays;
+    rays.reserve(batchSize);
+
+    for (long i = 0; i < batchSize; i++) {
+      vec3 const origin = RandomPoint(2.0f) + vec3(0, 0, 5);
+      vec3 const target = RandomPoint(1.5f);
+      rays.emplace_back(origin, (target - origin).Normalize(), 0.0f);
+    }
+
+    return rays;
+  }
+
+  std::vector<vec3> PointBatch(float extent) {
+    std::vector<vec3> points(batchSize);
+    for (auto &point : points) {
+      point = RandomPoint(extent);
+    }
+
+    return points;
+  }
+
+  // Counts hits so the calls can't be optimized away
+  template <typename Shape> bench::Result BenchHittable(std::string const &name, Shape const &shape,
+                                                        std::vector<rt::Ray> const &rays) {
+    return bench::Run(name, batchSize, [&] {
+      HitRecord rec;
+      int       hits = 0;
+      for (auto const &ray : rays) {
+        hits += shape.Hit(ray, 0.001f, 1e30f, rec);
+      }
+      bench::DoNotOptimize(hits);
+    });
+  }
+} // namespace
+
+int main() {
+  SetTraceLogLevel(LOG_WARNING);
+
+  auto const rays   = RayBatch();
+  auto const points = PointBatch(10.0f);
+
+  std::vector<bench::Result> results;
+
+  AABB const box(vec3(-1, -1, -1), vec3(1, 1, 1));
+  results.push_back(bench::Run("AABB::Hit", batchSize, [&] {
+    int hits = 0;
+    for (auto const &ray : rays) {
+      hits += box.Hit(ray, 0.001f, 1e30f);
+    }
+    bench::DoNotOptimize(hits);
+  }));
+
+  results.push_back(BenchHittable("Sphere::Hit", Sphere(1.0f), rays));
+
+  Triangle const triangle(vec3(-1, -1, 0), vec3(1, -1, 0), vec3(0, 1, 0));
+  results.push_back(BenchHittable("Triangle::Hit", triangle, rays));
+
+  results.push_back(BenchHittable("XYRect::Hit", XYRect(-1, 1, -1, 1, 0, nullptr), rays));
+  results.push_back(BenchHittable("XZRect::Hit", XZRect(-1, 1, -1, 1, 0, nullptr), rays));
+  results.push_back(BenchHittable("YZRect::Hit", YZRect(-1, 1, -1, 1, 0, nullptr), rays));
+
+  Transformation const transformation(vec3(1, 2, 3), vec3(30, 45, 60));
+  results.push_back(bench::Run("Transformation::Inverse", batchSize, [&] {
+    vec3 sum = vec3::Zero();
+    for (auto const &point : points) {
+      sum += transformation.Inverse(point);
+    }
+    bench::DoNotOptimize(sum);
+  }));
+
+  results.push_back(bench::Run("Transformation::ApplyInverseRotation", batchSize, [&] {
+    vec3 sum = vec3::Zero();
+    for (auto const &point : points) {
+      sum += transformation.ApplyInverseRotation(point);
+    }
+    bench::DoNotOptimize(sum);
+  }));
+
+  Perlin const perlin;
+  results.push_back(bench::Run("Perlin::Turb (7 octaves)", batchSize, [&] {
+    float sum = 0;
+    for (auto const &point : points) {
+      sum += perlin.Turb(point);
+    }
+    bench::DoNotOptimize(sum);
+  }));
+
+  SeedRandom(1234);
+  results.push_back(bench::Run("vec3::RandomInUnitSphere", batchSize, [&] {
+    vec3 sum = vec3::Zero();
+    for (long i = 0; i < batchSize; i++) {
+      sum += vec3::RandomInUnitSphere();
+    }
+    bench::DoNotOptimize(sum);
+  }));
+
+  bench::Print("Kernels (" + std::to_string(batchSize) + " inputs per batch)", results);
+  return 0;
+}
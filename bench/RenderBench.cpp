@@ -0,0 +1,160 @@
+#include "SceneRuns.h"
+
+#include "BVHNode.h"
+
+#include <argumentum/argparse.h>
+#include <nlohmann-json/json.hpp>
+#include <raylib.h>
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Renders every built-in scene and scene file headlessly with fixed settings, and reports the
+// wall time, throughput, BVH build time and peak memory of each as JSON, to compare commits.
+//
+// Usage: raytracer_bench [--width N] [--spp N] [--seed N] [--threads N] [--repetitions N]
+//                        [--output results.json] [scene.json ...]
+// Without scene files, every file in scenes/ is rendered after the built-in scenes.
+
+using namespace rt;
+using namespace rt::bench;
+using namespace argumentum;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+  struct Options {
+    int                      width       = 400;
+    int                      spp         = 16;
+    int                      seed        = 0;
+    int                      threads     = 6;
+    int                      repetitions = 1;
+    std::string              output;
+    std::vector<std::string> sceneFiles;
+  };
+
+  double MillisecondsSince(clock_type::time_point start) {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+  }
+
+  // Linux resets the peak resident set size (VmHWM) when "5" is written here, so each scene's
+  // peak isn't hidden by a larger one rendered before it
+  void ResetPeakRss() { std::ofstream("/proc/self/clear_refs") << "5"; }
+
+  long PeakRssKb() {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+      if (line.rfind("VmHWM:", 0) == 0)
+        return std::stol(line.substr(6));
+    }
+
+    // Peak of the whole process, the best that's available elsewhere
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+  }
+
+  json RunScene(std::string const &name, std::function<Scene()> const &load, Options const &options, RenderPool &pool) {
+    ResetPeakRss();
+
+    Scene scene = load();
+    scene.settings.samplesPerPixel = options.spp;
+    scene.settings.seed            = options.seed;
+
+    // The scene's own tree was built while loading it, along with everything else. Rebuilding
+    // it from the same objects times the build alone.
+    auto const objects    = scene.worldRoot->getChildrenAsList();
+    auto const buildStart = clock_type::now();
+    BVHNode    rebuilt(objects, scene.cam.time0, scene.cam.time1);
+    double     bvhBuildMs = MillisecondsSince(buildStart);
+
+    AsyncRenderData ard(scene.imageWidth, scene.imageHeight, scene.imageWidth, scene.imageHeight, options.threads);
+    ard.changeNumThreads(options.threads, pool.numNodes());
+    ard.setTraversalOrder(scene.settings.traversalOrder);
+
+    double bestMs = 0;
+    long   rays   = 0;
+
+    for (int r = 0; r < options.repetitions; r++) {
+      double const ms = RenderOnce(scene, ard, pool);
+      if (r == 0 || ms < bestMs)
+        bestMs = ms;
+
+      // The same seed traces the same rays every repetition
+      rays = 0;
+      for (auto const &stats : ard.threadStats) {
+        rays += stats.counters().rays();
+      }
+    }
+
+    return {{"name", name},
+            {"objects", objects.size()},
+            {"wall_ms", bestMs},
+            {"rays", rays},
+            {"mrays_per_s", rays / (bestMs * 1e3)},
+            {"bvh_build_ms", bvhBuildMs},
+            {"peak_rss_mb", PeakRssKb() / 1024.0}};
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+
+  Options         options;
+  argument_parser parser;
+
+  parser.config().program(argv[0]).description("Renders the built-in and saved scenes and reports timings as JSON");
+  parser.add_argument(options.width, "--width").maxargs(1).absent(options.width).help("Image width and height");
+  parser.add_argument(options.spp, "--spp").maxargs(1).absent(options.spp).help("Samples per pixel");
+  parser.add_argument(options.seed, "--seed").maxargs(1).absent(options.seed).help("Seed of every render");
+  parser.add_argument(options.threads, "--threads").maxargs(1).absent(options.threads).help("Render threads");
+  parser.add_argument(options.repetitions, "--repetitions")
+      .maxargs(1)
+      .absent(options.repetitions)
+      .help("Renders per scene, the fastest is reported");
+  parser.add_argument(options.output, "--output").maxargs(1).absent("").help("Write the results here instead of stdout");
+  parser.add_argument(options.sceneFiles, "scenes").minargs(0).help("Scene files, everything in scenes/ by default");
+
+  if (!parser.parse_args(argc, argv, 1))
+    return 1;
+
+  if (options.sceneFiles.empty())
+    options.sceneFiles = SceneFiles();
+
+  StdoutToStderr logs;
+
+  RenderPool pool(options.threads);
+  json       results = json::array();
+  int const  size    = options.width;
+
+  for (auto const &[name, build] : Scene::builtInScenes) {
+    std::cerr << "Rendering " << name << '\n';
+    results.push_back(RunScene(name, [&, &build = build] { return build(size, size); }, options, pool));
+  }
+
+  for (auto const &path : options.sceneFiles) {
+    std::cerr << "Rendering " << path << '\n';
+    results.push_back(RunScene(path, [&] { return Scene::Load(size, size, path); }, options, pool));
+  }
+
+  json const report = {{"width", size},
+                       {"height", size},
+                       {"samples_per_pixel", options.spp},
+                       {"seed", options.seed},
+                       {"threads", options.threads},
+                       {"scenes", results}};
+
+  if (options.output.empty()) {
+    logs.results << report.dump(2) << '\n';
+  } else if (!(std::ofstream(options.output) << report.dump(2) << '\n')) {
+    std::cerr << "Failed to write " << options.output << '\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,154 @@
+#include "SceneRuns.h"
+
+#include <argumentum/argparse.h>
+#include <raylib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Renders one scene at 1, 2, 4, ... up to N threads and reports, as CSV, how the render time
+// scales and where the workers lose time: blocked on the job queues' locks, or idle at the end
+// of the render waiting for the last workers to finish their tiles.
+//
+// Usage: scaling_bench [--threads N] [--width N] [--spp N] [--seed N] [--repetitions N]
+//                      [--output results.csv] [scene.json]
+// Renders the first built-in scene without a scene file.
+
+using namespace rt;
+using namespace rt::bench;
+using namespace argumentum;
+using clock_type = std::chrono::steady_clock;
+
+namespace {
+  struct Options {
+    int         threads     = int(std::max(1u, std::thread::hardware_concurrency()));
+    int         width       = 400;
+    int         spp         = 16;
+    int         seed        = 0;
+    int         repetitions = 3;
+    std::string output;
+    std::string sceneFile;
+  };
+
+  struct Run {
+    int    threads;
+    double wallMs;
+    long   rays;
+    double queueWaitMs; // Summed over the workers
+    double tailIdleMs;  // Summed over the workers, from their last tile to the end of the render
+  };
+
+  std::vector<int> ThreadCounts(int maxThreads) {
+    std::vector<int> counts;
+    for (int t = 1; t < maxThreads; t *= 2) {
+      counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+
+    return counts;
+  }
+
+  // Fastest of `repetitions` renders with `threads` workers
+  Run Measure(Scene const &scene, AsyncRenderData &ard, RenderPool &pool, int threads, int repetitions) {
+    // What `App::changeNumThreads` does, without the app's window
+    pool.resize(threads);
+    ard.changeNumThreads(threads, pool.numNodes());
+
+    Run best{threads, 0, 0, 0, 0};
+
+    for (int r = 0; r < repetitions; r++) {
+      std::vector<clock_type::time_point> returned(threads);
+
+      double const wallMs =
+          RenderOnce(scene, ard, pool, [&](int threadIndex) { returned[threadIndex] = clock_type::now(); });
+      auto const end = clock_type::now();
+      if (r > 0 && wallMs >= best.wallMs)
+        continue;
+
+      best.wallMs      = wallMs;
+      best.rays        = ard.totalCounters().rays();
+      best.queueWaitMs = ard.queueWaitMs();
+      best.tailIdleMs  = 0;
+      for (auto const &time : returned) {
+        best.tailIdleMs += std::chrono::duration<double, std::milli>(end - time).count();
+      }
+    }
+
+    return best;
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+
+  Options         options;
+  argument_parser parser;
+
+  parser.config().program(argv[0]).description("Renders a scene at increasing thread counts and reports scaling as CSV");
+  parser.add_argument(options.threads, "--threads")
+      .maxargs(1)
+      .absent(options.threads)
+      .help("Most threads to render with, all hardware threads by default");
+  parser.add_argument(options.width, "--width").maxargs(1).absent(options.width).help("Image width and height");
+  parser.add_argument(options.spp, "--spp").maxargs(1).absent(options.spp).help("Samples per pixel");
+  parser.add_argument(options.seed, "--seed").maxargs(1).absent(options.seed).help("Seed of every render");
+  parser.add_argument(options.repetitions, "--repetitions")
+      .maxargs(1)
+      .absent(options.repetitions)
+      .help("Renders per thread count, the fastest is reported");
+  parser.add_argument(options.output, "--output").maxargs(1).absent("").help("Write the results here instead of stdout");
+  parser.add_argument(options.sceneFile, "scene").minargs(0).maxargs(1).absent("").help("Scene file to render");
+
+  if (!parser.parse_args(argc, argv, 1))
+    return 1;
+
+  options.threads = std::max(options.threads, 1);
+  int const size  = options.width;
+
+  StdoutToStderr logs;
+
+  Scene scene = options.sceneFile.empty() ? Scene::builtInScenes.front().second(size, size)
+                                          : Scene::Load(size, size, options.sceneFile);
+  scene.settings.samplesPerPixel = options.spp;
+  scene.settings.seed            = options.seed;
+
+  AsyncRenderData ard(size, size, size, size, 1);
+  RenderPool      pool(1);
+  ard.setTraversalOrder(scene.settings.traversalOrder);
+
+  std::vector<Run> runs;
+  for (int threads : ThreadCounts(options.threads)) {
+    std::cerr << "Rendering with " << threads << " threads\n";
+    runs.push_back(Measure(scene, ard, pool, threads, options.repetitions));
+  }
+
+  std::ofstream file;
+  if (!options.output.empty()) {
+    file.open(options.output);
+    if (!file) {
+      std::cerr << "Failed to write " << options.output << '\n';
+      return 1;
+    }
+  }
+
+  std::ostream &out = options.output.empty() ? logs.results : file;
+  out << "threads,wall_ms,speedup,efficiency,mrays_per_s,queue_wait_ms,tail_idle_ms\n";
+
+  double const baseMs = runs.front().wallMs;
+  for (auto const &run : runs) {
+    char         line[256];
+    double const speedup = baseMs / run.wallMs;
+
+    std::snprintf(line, sizeof(line), "%d,%.2f,%.3f,%.3f,%.3f,%.3f,%.2f\n", run.threads, run.wallMs, speedup,
+                  speedup / run.threads, run.rays / (run.wallMs * 1e3), run.queueWaitMs, run.tailIdleMs);
+    out << line;
+  }
+
+  return out ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AsyncRenderData.h"
+#include "Ray.h"
+#include "RenderPool.h"
+#include "Scene.h"
+
+#include <nlohmann-json/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// What the tools rendering whole scenes (the scene benchmarks and regression_images) share.
+// They're run from the repository's root: scene files are found in scenes/, and scenes load
+// their textures from relative paths.
+namespace rt::bench {
+  // Files saved before objects had transforms (scenes/test.json) crash the loader, which
+  // expects every object to have one
+  inline bool IsLoadable(std::string const &path) {
+    std::ifstream        file(path);
+    nlohmann::json const scene = nlohmann::json::parse(file, nullptr, false);
+    if (scene.is_discarded() || !scene.contains("objects"))
+      return false;
+
+    return std::all_of(scene["objects"].begin(), scene["objects"].end(),
+                       [](nlohmann::json const &object) { return object.contains("transform"); });
+  }
+
+  // The scene files in `directory` that can be loaded, sorted by path
+  inline std::vector<std::string> SceneFiles(std::string const &directory = "scenes") {
+    std::vector<std::string> files;
+    if (!std::filesystem::is_directory(directory))
+      return files;
+
+    for (auto const &entry : std::filesystem::directory_iterator(directory)) {
+      if (entry.path().extension() != ".json")
+        continue;
+
+      if (IsLoadable(entry.path().string()))
+        files.push_back(entry.path().string());
+      else
+        std::cerr << "Skipping " << entry.path().string() << ", it's in an older format\n";
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+  }
+
+  // Resets `ard` and renders `scene` as its settings are with every worker of `pool`, returns
+  // the time it took in milliseconds. `returned` is called by each worker once it has no tiles
+  // left.
+  inline double RenderOnce(Scene const &scene, AsyncRenderData &ard, RenderPool &pool,
+                           std::function<void(int threadIndex)> const &returned = {}) {
+    using clock_type = std::chrono::steady_clock;
+
+    ard.reset();
+
+    auto const start  = clock_type::now();
+    auto       handle = pool.submit([&](int threadIndex, CancellationToken const &token) {
+      rt::Ray::Trace(ard, &scene, threadIndex, pool.nodeOf(threadIndex), token);
+      if (returned)
+        returned(threadIndex);
+    });
+    handle.wait();
+
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+  }
+
+  /**
+   * @brief Scene loading logs to stdout, this sends it to stderr while it's alive so stdout only
+   * has the results, which are written to `results`.
+   */
+  class StdoutToStderr {
+  public:
+    StdoutToStderr() : results(std::cout.rdbuf(std::cerr.rdbuf())) {}
+    ~StdoutToStderr() { std::cout.rdbuf(results.rdbuf()); }
+
+    StdoutToStderr(StdoutToStderr const &)            = delete;
+    StdoutToStderr &operator=(StdoutToStderr const &) = delete;
+
+    std::ostream results; // Writes to the real stdout
+  };
+} // namespace rt::bench
@@ -0,0 +1,127 @@
+#include "Bench.h"
+
+#include "textures/MipPyramid.h"
+#include "textures/TexelLayout.h"
+
+#include <raylib.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares texel layouts for the mip pyramid ImageTexture samples from.
+//
+// Usage: texture_bench [path to image]
+// Without an image, a 4096x2048 noise texture (about the size of the skysphere) is used.
+
+using namespace rt;
+
+namespace {
+  const long samplesPerCall = 1 << 16;
+
+  struct Lookup {
+    float u, v, lod;
+  };
+
+  // Random uvs over the whole texture, like secondary rays after diffuse bounces
+  std::vector<Lookup> IncoherentLookups(float lod) {
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<Lookup> lookups(samplesPerCall);
+    for (auto &lookup : lookups) {
+      lookup = {dist(rng), dist(rng), lod};
+    }
+
+    return lookups;
+  }
+
+  // A 256x256 pixel block of camera rays hitting the texture, jittered inside each pixel
+  std::vector<Lookup> CoherentLookups(float lod) {
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+
+    std::vector<Lookup> lookups;
+    lookups.reserve(samplesPerCall);
+
+    for (int y = 0; y < 256; y++) {
+      for (int x = 0; x < 256; x++) {
+        lookups.push_back({0.3f + (x + jitter(rng)) / 2048.0f, 0.3f + (y + jitter(rng)) / 2048.0f, lod});
+      }
+    }
+
+    return lookups;
+  }
+
+  Image NoiseImage(int width, int height) {
+    std::mt19937 rng(42);
+
+    auto *data = (unsigned char *)std::malloc(std::size_t(width) * height * 3);
+    for (std::size_t i = 0; i < std::size_t(width) * height * 3; i++) {
+      data[i] = rng() & 0xFF;
+    }
+
+    Image image{};
+    image.data    = data;
+    image.width   = width;
+    image.height  = height;
+    image.mipmaps = 1;
+    image.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8;
+    return image;
+  }
+
+  template <typename Layout>
+  void BenchLayout(std::string const &layoutName, Image const &image, std::vector<bench::Result> &results) {
+    BasicMipPyramid<Layout> mips(image);
+
+    struct Case {
+      const char         *name;
+      std::vector<Lookup> lookups;
+      bool                trilinear;
+    };
+
+    Case const cases[] = {
+        {"bilinear, coherent", CoherentLookups(0.0f), false},
+        {"bilinear, incoherent", IncoherentLookups(0.0f), false},
+        {"trilinear, coherent", CoherentLookups(0.5f), true},
+        {"trilinear, incoherent", IncoherentLookups(0.5f), true},
+    };
+
+    for (auto const &c : cases) {
+      results.push_back(bench::Run(layoutName + ", " + c.name, samplesPerCall, [&] {
+        vec3 sum = vec3::Zero();
+        for (auto const &lookup : c.lookups) {
+          sum += c.trilinear ? mips.Trilinear(lookup.u, lookup.v, lookup.lod) : mips.Bilinear(0, lookup.u, lookup.v);
+        }
+        bench::DoNotOptimize(sum);
+      }));
+    }
+  }
+} // namespace
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+
+  Image image;
+  if (argc > 1) {
+    image = LoadImage(argv[1]);
+    if (image.data == nullptr)
+      return 1;
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+  } else {
+    image = NoiseImage(4096, 2048);
+  }
+
+  std::vector<bench::Result> results;
+  BenchLayout<RowMajorLayout>("row-major", image, results);
+  BenchLayout<BlockLayout<4>>("4x4 blocks", image, results);
+  BenchLayout<BlockLayout<8>>("8x8 blocks", image, results);
+
+  bench::Print("Texture sampling (" + std::to_string(image.width) + "x" + std::to_string(image.height) + ")", results);
+
+  UnloadImage(image);
+  return 0;
+}
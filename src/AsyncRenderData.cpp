@@ -1,49 +1,200 @@
 #include "AsyncRenderData.h"
+#include "Constants.h"
 #include "data_structures/JobQueue.h"
-#include "data_structures/Pixel.h"
 
 
 namespace rt {
 AsyncRenderData::AsyncRenderData(int imageWidth, int imageHeight,
                                  int editorWidth, int editorHeight,
-                                 int numThreads)
-    : threadProgress(std::vector(numThreads, 0)),
-      threadTimes(std::vector(numThreads, 0L)),
-      finishedThreads(std::vector(numThreads, false)) {
+                                 int numThreads, int numNodes, sPtr<TileSink> sink)
+    : frameBuffer(imageWidth, imageHeight, rt::constants::tileSize, TraversalOrder::scanline, false, sink == nullptr),
+      tileSink(std::move(sink)),
+      threadStats(numThreads),
+      pixelOrder(traversalOrder(TraversalOrder::scanline, rt::constants::tileSize, rt::constants::tileSize)),
+      numNodes(numNodes) {
 
-  int queueChunkSize = imageWidth * 4;
-  pixelJobs = std::make_shared<JobQueue<Pixel>>(imageWidth * imageHeight,
-                                                queueChunkSize);
+  // Headless renders have no GL context to create it in
+  if (IsWindowReady())
+    raytraceRT = LoadRenderTexture(imageWidth, imageHeight);
 
-  raytraceRT = LoadRenderTexture(imageWidth, imageHeight);
+  prepareJobs();
+}
+
+  void AsyncRenderData::prepareJobs(bool skipFinished) {
+    auto const &tiles = frameBuffer.getTiles();
+
+    tileJobs.clear();
+    skippedTiles = 0;
+
+    if (!skipFinished) {
+      tileFinished = std::make_unique<std::atomic<bool>[]>(tiles.size());
+      tileCosts    = std::make_unique<std::atomic<float>[]>(tiles.size());
+    }
+
+    // Tiles are laid out contiguously in the framebuffer, splitting them into contiguous slices
+    // keeps each node's part of the framebuffer in whole pages (except at the seams)
+    for (int node = 0; node < numNodes; node++) {
+      size_t const first = tiles.size() * node / numNodes;
+      size_t const last  = tiles.size() * (node + 1) / numNodes;
+
+      // One tile per chunk, tiles are already large enough to amortize the queue's lock
+      auto queue = std::make_shared<JobQueue<Tile>>(last - first, 1);
+
+      for (size_t i = first; i < last; i++) {
+        if (skipFinished && isFinished(i)) {
+          skippedTiles++;
+          continue;
+        }
 
-  // Prepare pixel jobs
-  for (int y = 0; y < imageHeight; y++) {
-    for (int x = 0; x < imageWidth; x++) {
-      pixelJobs->addJobNoLock(Pixel{x, y, vec3::Zero()});
+        queue->addJobNoLock(tiles[i]);
+      }
+
+      tileJobs.push_back(queue);
     }
   }
-}
 
-  void AsyncRenderData::KillThreads() {
-    this->pixelJobs->awakeAllWorkers();
+  void AsyncRenderData::reset() {
+    // The previous render was resumed, bring the skipped tiles back
+    if (skippedTiles > 0)
+      prepareJobs();
+
+    for (auto &queue : tileJobs) {
+      queue->setCurrentChunkStart(0);
+      queue->resetWaitTime();
+    }
+
+    for (size_t i = 0; i < frameBuffer.getTiles().size(); i++) {
+      tileFinished[i].store(false, std::memory_order_relaxed);
+      tileCosts[i].store(0, std::memory_order_relaxed);
+    }
+
+    for (auto &stats : threadStats) {
+      stats.reset();
+    }
+
+    region.reset();
+  }
+
+  bool AsyncRenderData::allTilesFinished() const {
+    for (int i = 0; i < totalTiles(); i++) {
+      if (!isFinished(i))
+        return false;
+    }
+
+    return true;
+  }
+
+  void AsyncRenderData::restrictTo(Region const &r, bool keepPrevious) {
+    // Streamed frames have no planes to clear
+    if (!keepPrevious && frameBuffer.isResident())
+      frameBuffer.clear();
+
+    for (auto const &tile : frameBuffer.getTiles()) {
+      if (!r.intersects(tile))
+        markFinished(tile);
+    }
+
+    skipFinishedTiles();
+    region = r;
+  }
+
+  AsyncRenderData::TileRange AsyncRenderData::nextTiles(int node, bool &stolen) {
+    stolen = false;
+
+    auto range = tileJobs[node]->getChunk();
+    for (int i = 1; range.first == range.second && i < numNodes; i++) {
+      range  = tileJobs[(node + i) % numNodes]->getChunk();
+      stolen = true;
+    }
+
+    return range;
+  }
+
+  void AsyncRenderData::skipFinishedTiles() { prepareJobs(true); }
+
+  int AsyncRenderData::finishedTiles() const {
+    int finished = 0;
+    for (int i = 0; i < totalTiles(); i++) {
+      finished += isFinished(i);
+    }
+
+    return finished;
+  }
+
+  int AsyncRenderData::totalTiles() const { return frameBuffer.getTiles().size(); }
+
+  RayCounters AsyncRenderData::totalCounters() const {
+    RayCounters total;
+    for (auto const &stats : threadStats) {
+      total += stats.counters();
+    }
 
-    // Tell threads to exit
-    this->exit = true;
+    return total;
+  }
 
-    // Join threads
-    for (auto &&t : this->threads) {
-      t->join();
+  double AsyncRenderData::queueWaitMs() const {
+    long nanoseconds = 0;
+    for (auto const &queue : tileJobs) {
+      nanoseconds += queue->getWaitNanoseconds();
     }
 
-    // Clear thread vector
-    this->threads.clear();
+    return nanoseconds / 1e6;
   }
 
-  void AsyncRenderData::changeNumThreads(int newNumThreads) {
-    KillThreads();
-    threadProgress.resize(newNumThreads);
-    threadTimes.resize(newNumThreads);
-    finishedThreads.resize(newNumThreads);
+  void AsyncRenderData::resize(int imageWidth, int imageHeight) {
+    if (imageWidth == frameBuffer.getWidth() && imageHeight == frameBuffer.getHeight())
+      return;
+
+    rebuildFrameBuffer(imageWidth, imageHeight, frameBuffer.getTileOrder(), frameBuffer.hasAovs());
+
+    for (auto &stats : threadStats) {
+      stats.reset();
+    }
+
+    if (IsWindowReady()) {
+      UnloadRenderTexture(raytraceRT);
+      raytraceRT = LoadRenderTexture(imageWidth, imageHeight);
+    }
+  }
+
+  void AsyncRenderData::setTraversalOrder(TraversalOrder order) {
+    if (order == frameBuffer.getTileOrder())
+      return;
+
+    rebuildFrameBuffer(frameBuffer.getWidth(), frameBuffer.getHeight(), order, frameBuffer.hasAovs());
+    pixelOrder = traversalOrder(order, rt::constants::tileSize, rt::constants::tileSize);
+  }
+
+  void AsyncRenderData::setAovs(bool enabled) {
+    if (enabled == frameBuffer.hasAovs())
+      return;
+
+    rebuildFrameBuffer(frameBuffer.getWidth(), frameBuffer.getHeight(), frameBuffer.getTileOrder(), enabled);
+  }
+
+  void AsyncRenderData::setTileSink(sPtr<TileSink> sink) {
+    tileSink = std::move(sink);
+
+    if (tileSink)
+      frameBuffer.releasePlanes();
+    else if (!frameBuffer.isResident())
+      rebuildFrameBuffer(frameBuffer.getWidth(), frameBuffer.getHeight(), frameBuffer.getTileOrder(),
+                         frameBuffer.hasAovs());
+  }
+
+  void AsyncRenderData::rebuildFrameBuffer(int imageWidth, int imageHeight, TraversalOrder order, bool withAovs) {
+    frameBuffer = FrameBuffer(imageWidth, imageHeight, rt::constants::tileSize, order, withAovs, tileSink == nullptr);
+
+    prepareJobs();
+  }
+
+  void AsyncRenderData::changeNumThreads(int newNumThreads, int newNumNodes) {
+    // ThreadStats holds atomics and can't be moved, so the vector is rebuilt instead of resized
+    threadStats = std::vector<ThreadStats>(newNumThreads);
+
+    if (newNumNodes != numNodes) {
+      numNodes = newNumNodes;
+      prepareJobs();
+    }
   }
 } // namespace rt
@@ -1,42 +1,134 @@
 #pragma once
 #include "Defs.h"
-#include "data_structures/Pixel.h"
+#include "data_structures/FrameBuffer.h"
+#include "data_structures/Region.h"
+#include "data_structures/ThreadStats.h"
+#include "data_structures/Tile.h"
+#include "data_structures/TraversalOrder.h"
 
 #include <raylib.h>
 
-#include <thread>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace rt {
 
   template<typename JobData> class JobQueue;
+  class TileSink;
 
+  /**
+   * @brief Buffers shared between the render workers and the UI.
+   *
+   * Lives as long as the app does. Re-rendering at the same resolution reuses every allocation,
+   * changing the resolution or the number of threads only rebuilds what depends on it.
+   */
   struct AsyncRenderData {
-    std::vector<sPtr<std::thread>> threads;
+    using TileRange = std::pair<std::vector<Tile>::iterator, std::vector<Tile>::iterator>;
 
-    sPtr<JobQueue<Pixel>> pixelJobs;
+    // One queue per NUMA node the workers are spread over, each holding a contiguous slice of
+    // the framebuffer's tiles
+    std::vector<sPtr<JobQueue<Tile>>> tileJobs;
 
-    std::vector<long> threadTimes;
-    std::vector<int>  threadProgress;
-    std::vector<bool> finishedThreads;
+    FrameBuffer frameBuffer;
 
-    bool exit = false; // To make threads exit their loops
+    // When set, workers render each tile into a scratch buffer and hand it here instead of
+    // keeping it in `frameBuffer`, whose planes are then never allocated
+    sPtr<TileSink> tileSink;
+
+    // Set by `restrictTo`, workers only write the pixels inside it and keep the rest of the
+    // tiles it crosses as they were
+    std::optional<Region> region;
+
+    std::vector<ThreadStats> threadStats;
+
+    // Pixel offsets inside a full tile in the order they're rendered in. Partial tiles at the
+    // image's edges skip the offsets that fall outside of them.
+    std::vector<std::pair<int, int>> pixelOrder;
 
     RenderTexture2D raytraceRT;
 
   public:
     AsyncRenderData() = default;
 
+    // With a `sink`, tiles are streamed to it from the start and the framebuffer's planes are
+    // never allocated
     AsyncRenderData(int imageWidth, int imageHeight, int editorWidth,
-                    int editorHeight, int numThreads);
+                    int editorHeight, int numThreads, int numNodes = 1, sPtr<TileSink> sink = nullptr);
+
+    // Rewinds the job queues and clears thread stats, finished tiles and the render region. The framebuffer isn't
+    // cleared here, workers clear each tile before rendering it so its memory is first touched locally.
+    void reset();
+
+    // Called by a worker once it wrote all of `tile`'s pixels, along with the time it took. Finished
+    // tiles aren't touched again until the next `reset`, so other threads can read them while the
+    // render goes on. Tiles skipped rather than rendered have no cost.
+    void markFinished(Tile const &tile, float costMs = 0) {
+      int const index = frameBuffer.tileIndex(tile);
+      tileCosts[index].store(costMs, std::memory_order_relaxed);
+      tileFinished[index].store(true, std::memory_order_release);
+    }
+
+    bool isFinished(int tileIndex) const { return tileFinished[tileIndex].load(std::memory_order_acquire); }
+
+    // Worker time spent rendering the tile in ms, 0 until it's finished or if it was skipped
+    float tileCost(int tileIndex) const { return tileCosts[tileIndex].load(std::memory_order_relaxed); }
+
+    // Drops the tiles marked finished from the job queues, for renders resumed from a checkpoint.
+    // Undone by the next `reset`.
+    void skipFinishedTiles();
+
+    // True once every tile was rendered (or skipped) since the last `reset` or rebuild
+    bool allTilesFinished() const;
+
+    // Only renders the tiles overlapping `r`, the others are marked finished and skipped. Their
+    // pixels are kept from the previous render if `keepPrevious`, cleared otherwise. Call after
+    // `reset` and before submitting the render.
+    void restrictTo(Region const &r, bool keepPrevious);
+
+    // Next tiles for a worker on `node`. Takes from the node's own queue first, and steals
+    // from the other nodes' queues once it's empty. An empty range means all tiles are taken.
+    TileRange nextTiles(int node, bool &stolen);
+
+    // Number of tiles finished so far, including the ones skipped by a crop or when resuming
+    int finishedTiles() const;
+    int totalTiles() const;
+
+    // Sum of the workers' published counters
+    RayCounters totalCounters() const;
+
+    // Time workers spent blocked on the job queues' locks since the last `reset`, summed over all of them
+    double queueWaitMs() const;
+
+    // Reallocates the framebuffer and jobs if the resolution changed, keeps them otherwise
+    void resize(int imageWidth, int imageHeight);
+
+    void changeNumThreads(int newNumThreads, int newNumNodes = 1);
+
+    // Relays out the framebuffer's tiles and the pixels inside them if the order changed
+    void setTraversalOrder(TraversalOrder order);
+
+    // Adds or drops the framebuffer's AOV planes, they cost 7 extra floats per pixel
+    void setAovs(bool enabled);
+
+    // Streams tiles to `sink` from now on and frees the framebuffer's planes, or brings them
+    // back if `sink` is null. Streaming from the start is better set up by the constructor,
+    // which doesn't allocate the planes in the first place.
+    void setTileSink(sPtr<TileSink> sink);
 
-    AsyncRenderData(sPtr<JobQueue<Pixel>> pj, std::vector<long> tt, std::vector<int> tp, std::vector<bool> ft)
-        : pixelJobs(pj), threadTimes(tt), threadProgress(tp), finishedThreads(ft) {}
+  private:
+    // Rebuilds the framebuffer (and the jobs over its tiles), allocating its planes unless tiles are streamed out
+    void rebuildFrameBuffer(int imageWidth, int imageHeight, TraversalOrder order, bool withAovs);
 
-    void KillThreads();
+    // Splits the tiles between the nodes' queues, leaving finished ones out if `skipFinished`
+    void prepareJobs(bool skipFinished = false);
 
-    void changeNumThreads(int newNumThreads);
+    int numNodes = 1;
 
-    ~AsyncRenderData() { KillThreads(); }
+    std::unique_ptr<std::atomic<bool>[]>  tileFinished; // Indexed like `frameBuffer.getTiles()`
+    std::unique_ptr<std::atomic<float>[]> tileCosts;    // Indexed like `frameBuffer.getTiles()`
+    int                                   skippedTiles = 0;
   };
 } // namespace rt
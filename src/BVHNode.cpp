@@ -1,6 +1,8 @@
 #include "BVHNode.h"
 
+#include "TraceEvents.h"
 #include "Util.h"
+#include "data_structures/RayCounters.h"
 #include "data_structures/vec3.h"
 
 #include <algorithm>
@@ -45,6 +47,8 @@ rt::BVHNode::BVHNode(const HittableList &list, float t0, float t1)
 
 rt::BVHNode::BVHNode(const std::vector<sPtr<Hittable>> &srcObjects, size_t start, size_t end, float t0, float t1)
     : Hittable("BVH Node") {
+  // The whole build, not every node of it
+  TraceScope const trace("Build BVH", start == 0 && end == srcObjects.size());
 
   if (srcObjects.empty()) {
     left  = nullptr;
@@ -98,6 +102,8 @@ rt::BVHNode::BVHNode(const std::vector<sPtr<Hittable>> &srcObjects, size_t start
 }
 
 bool rt::BVHNode::Hit(const Ray &r, float t_min, float t_max, HitRecord &rec) const {
+  RayCounters::Local().nodesVisited++;
+
   if (!box.Hit(r, t_min, t_max))
     return false;
 
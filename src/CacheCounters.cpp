@@ -0,0 +1,82 @@
+#include "CacheCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+#ifdef __linux__
+  int openCounter(std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = config;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    // Calling thread, any CPU
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  std::int64_t readCounter(int fd) {
+    std::int64_t value = 0;
+    if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value))
+      return 0;
+
+    return value;
+  }
+#endif
+} // namespace
+
+namespace rt {
+#ifdef __linux__
+  CacheCounters::CacheCounters() {
+    // The generic hardware cache events count last-level cache accesses on most CPUs
+    referencesFd = openCounter(PERF_COUNT_HW_CACHE_REFERENCES);
+    missesFd     = openCounter(PERF_COUNT_HW_CACHE_MISSES);
+  }
+
+  CacheCounters::~CacheCounters() {
+    if (referencesFd != -1)
+      close(referencesFd);
+    if (missesFd != -1)
+      close(missesFd);
+  }
+
+  void CacheCounters::start() {
+    if (!available())
+      return;
+
+    ioctl(referencesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(referencesFd, PERF_EVENT_IOC_ENABLE, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  void CacheCounters::stop() {
+    if (!available())
+      return;
+
+    ioctl(referencesFd, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(missesFd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  std::int64_t CacheCounters::references() const { return available() ? readCounter(referencesFd) : 0; }
+
+  std::int64_t CacheCounters::misses() const { return available() ? readCounter(missesFd) : 0; }
+#else
+  CacheCounters::CacheCounters() {}
+  CacheCounters::~CacheCounters() {}
+  void         CacheCounters::start() {}
+  void         CacheCounters::stop() {}
+  std::int64_t CacheCounters::references() const { return 0; }
+  std::int64_t CacheCounters::misses() const { return 0; }
+#endif
+} // namespace rt
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rt {
+  /**
+   * @brief Last-level cache references and misses of the calling thread, read through
+   * perf_event_open.
+   *
+   * Counting is per thread, so an instance has to be created, started and read on the thread
+   * being measured. Where perf events aren't available (non-Linux, containers, or a restrictive
+   * perf_event_paranoid) `available()` is false and the counts stay at zero.
+   */
+  class CacheCounters {
+  public:
+    CacheCounters();
+    ~CacheCounters();
+
+    CacheCounters(CacheCounters const &)            = delete;
+    CacheCounters &operator=(CacheCounters const &) = delete;
+
+    bool available() const { return referencesFd != -1 && missesFd != -1; }
+
+    void start();
+    void stop();
+
+    std::int64_t references() const;
+    std::int64_t misses() const;
+
+  private:
+    int referencesFd = -1;
+    int missesFd     = -1;
+  };
+} // namespace rt
@@ -50,14 +50,22 @@ Camera::Camera(vec3 lookFrom, vec3 lookAt, vec3 vUp, float vFov,
   }
 
   // Used for raytracing
-  rt::Ray Camera::GetRay(float s, float t) const {
+  rt::Ray Camera::GetRay(float s, float t, float pixelSpread) const {
     vec3 rd     = lensRadius * vec3::RandomInUnitDisc();
     vec3 offset = localRight * rd.x + localUp * rd.y;
-    return rt::Ray(
+    rt::Ray ray(
         lookFrom + offset,
         (lowerLeftCorner + horizontal * s + vertical * t - lookFrom - offset).Normalize(),
         RandomFloat(time0, time1)
     );
+    ray.spread = pixelSpread;
+
+    return ray;
+  }
+
+  float Camera::PixelSpread(int imageHeight) const {
+    float theta = DegressToRadians(vFov);
+    return 2 * tan(theta / 2) / imageHeight;
   }
 
 
@@ -39,7 +39,11 @@ namespace rt {
 
     Camera(nlohmann::json cameraJson, float aspectRatio);
 
-    rt::Ray GetRay(float s, float t) const;
+    // `pixelSpread` is the angle a single pixel covers, see `PixelSpread`
+    rt::Ray GetRay(float s, float t, float pixelSpread = 0.0f) const;
+
+    // Vertical angle covered by one pixel of an image `imageHeight` pixels tall
+    float PixelSpread(int imageHeight) const;
 
     void                         RenderImgui();
     std::tuple<vec3, vec3, vec3> getScaledDirectionVectors(float dt) const;
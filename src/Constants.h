@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <limits>
 
 namespace rt::constants {
@@ -6,4 +7,13 @@ namespace rt::constants {
   const float infinity = std::numeric_limits<float>::infinity();
   const float epsilon  = 1e-6;
   const auto  title    = "rt";
+
+  // Per-thread data written by render workers is padded to this to avoid false sharing
+  const std::size_t cacheLineSize = 64;
+
+  // Edge length (in pixels) of the square tiles the frame is split into for rendering
+  const int tileSize = 16;
+
+  // Minimum spread (in radians) of the ray cone leaving a diffuse surface, used for texture LODs
+  const float diffuseConeSpread = 0.1f;
 } // namespace rt::costants
@@ -0,0 +1,118 @@
+#include "DirtyRegion.h"
+
+#include "Camera.h"
+#include "Hittable.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace rt {
+  namespace {
+    // Pixels the box covers, including the blur of out of focus corners and a pixel of margin
+    // for the jittered samples. No value if part of the box is behind the camera.
+    std::optional<Region> ScreenBounds(AABB const &box, Camera const &cam, int width, int height) {
+      float const lensRadius    = cam.aperature / 2;
+      float const horizontalLen = cam.horizontal.Len(), verticalLen = cam.vertical.Len();
+
+      float sMin = std::numeric_limits<float>::max(), tMin = sMin;
+      float sMax = std::numeric_limits<float>::lowest(), tMax = sMax;
+
+      for (int corner = 0; corner < 8; corner++) {
+        vec3 const p(corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                     corner & 4 ? box.max.z : box.min.z);
+
+        vec3 const  toPoint = p - cam.lookFrom;
+        float const depth   = vec3::DotProd(toPoint, cam.localForward);
+        if (depth <= 1e-4f)
+          return std::nullopt;
+
+        // Where the line to the corner crosses the focus plane, which the image's corners span
+        vec3 const  onPlane = cam.lookFrom + toPoint * (cam.focusDist / depth) - cam.lowerLeftCorner;
+        float const s       = vec3::DotProd(onPlane, cam.horizontal) / (horizontalLen * horizontalLen);
+        float const t       = vec3::DotProd(onPlane, cam.vertical) / (verticalLen * verticalLen);
+
+        // Rays leaving the lens off center cross the focus plane this far from the corner's projection
+        float const blur = lensRadius * std::fabs(1 - cam.focusDist / depth);
+
+        sMin = std::min(sMin, s - blur / horizontalLen);
+        sMax = std::max(sMax, s + blur / horizontalLen);
+        tMin = std::min(tMin, t - blur / verticalLen);
+        tMax = std::max(tMax, t + blur / verticalLen);
+      }
+
+      // Pixel x samples s in [x, x + 1] / (width - 1), see `Ray::Trace`. Clamped before the
+      // conversion, corners close to the camera's plane project arbitrarily far away.
+      auto const toPixel = [](float st, int size) { return int(std::floor(std::clamp(st, -1.0f, 2.0f) * (size - 1))); };
+
+      return Region{toPixel(sMin, width) - 1, toPixel(tMin, height) - 1, toPixel(sMax, width) + 2,
+                    toPixel(tMax, height) + 2}
+          .clamped(width, height);
+    }
+  } // namespace
+
+  SceneSnapshot SceneSnapshot::Take(Scene const &scene) {
+    SceneSnapshot snapshot;
+
+    // Everything in the scene's JSON but the objects, plus the resolution and debug view
+    snapshot.frame = {{"camera", scene.cam},
+                      {"background_color", scene.backgroundColor},
+                      {"num_samples", scene.settings.samplesPerPixel},
+                      {"max_depth", scene.settings.maxDepth},
+                      {"sample_environment", scene.settings.sampleEnvironment},
+                      {"seed", scene.settings.seed},
+                      {"debug_view", scene.settings.debugViewDescription()},
+                      {"width", scene.imageWidth},
+                      {"height", scene.imageHeight}};
+
+    if (scene.environment)
+      snapshot.frame["environment"] = {{"path", scene.environment->getPath()},
+                                       {"intensity", scene.environment->getIntensity()}};
+
+    for (auto const &object : scene.worldRoot->getChildrenAsList()) {
+      Object entry;
+      entry.description = object->toJson();
+      entry.bounded     = object->BoundingBox(scene.cam.time0, scene.cam.time1, entry.box);
+
+      snapshot.objects.emplace(object.get(), std::move(entry));
+    }
+
+    return snapshot;
+  }
+
+  std::optional<Region> DirtyRegion(SceneSnapshot const &previous, SceneSnapshot const &current, Scene const &scene) {
+    if (previous.frame != current.frame)
+      return std::nullopt;
+
+    Camera const &cam = scene.cam;
+    Region        dirty;
+
+    // Adds where `object` was drawn, false if that can't be known
+    auto const cover = [&](SceneSnapshot::Object const &object) {
+      auto const bounds = object.bounded ? ScreenBounds(object.box, cam, scene.imageWidth, scene.imageHeight)
+                                         : std::nullopt;
+      if (bounds)
+        dirty = dirty.united(*bounds);
+
+      return bounds.has_value();
+    };
+
+    for (auto const &[key, object] : current.objects) {
+      auto const before = previous.objects.find(key);
+      if (before != previous.objects.end() && before->second.description == object.description)
+        continue;
+
+      if (!cover(object) || (before != previous.objects.end() && !cover(before->second)))
+        return std::nullopt;
+    }
+
+    // Removed objects leave a hole where they were
+    for (auto const &[key, object] : previous.objects) {
+      if (!current.objects.contains(key) && !cover(object))
+        return std::nullopt;
+    }
+
+    return dirty;
+  }
+} // namespace rt
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "AABB.h"
+#include "Defs.h"
+#include "data_structures/Region.h"
+
+#include <optional>
+#include <unordered_map>
+
+namespace rt {
+  class Hittable;
+  class Scene;
+
+  /**
+   * @brief What a render was made of, compared with the scene before the next render to find
+   * the part of the image that changed.
+   *
+   * Objects are told apart by address (the editor keeps them alive across BVH rebuilds) and
+   * compared by their JSON description.
+   */
+  struct SceneSnapshot {
+    struct Object {
+      json description;
+      AABB box;
+      bool bounded; // Objects without a bounding box can't be projected
+    };
+
+    json                                         frame; // Camera, settings, environment and resolution
+    std::unordered_map<Hittable const *, Object> objects;
+
+    static SceneSnapshot Take(Scene const &scene);
+  };
+
+  // Screen-space bounds (framebuffer coordinates) of the objects that were added, removed or
+  // changed between `previous` and `scene`, covering both where they were and where they are.
+  // Empty if nothing changed, no value if the whole image has to be rendered again: the camera,
+  // settings or environment changed, or a changed object can't be projected (unbounded, or
+  // crossing the camera's plane).
+  //
+  // Only direct visibility is accounted for, shadows or reflections of a changed object falling
+  // outside of its bounds keep their old look until the next full render.
+  std::optional<Region> DirtyRegion(SceneSnapshot const &previous, SceneSnapshot const &current, Scene const &scene);
+} // namespace rt
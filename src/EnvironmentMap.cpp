@@ -0,0 +1,169 @@
+#include "EnvironmentMap.h"
+
+#include "Constants.h"
+#include "TraceEvents.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace rt {
+
+  sPtr<EnvironmentMap> EnvironmentMap::Load(std::string const &path, float intensity) {
+    TraceScope const trace("Decode environment map");
+
+    ::Image img = LoadImage(path.c_str());
+    if (img.data == nullptr) {
+      std::cerr << "Failed to load environment map " << path << '\n';
+      return nullptr;
+    }
+
+    // .hdr files decode to floats already, 8 bit images get normalized to [0, 1]
+    ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R32G32B32);
+
+    auto env       = std::make_shared<EnvironmentMap>();
+    env->path      = path;
+    env->intensity = intensity;
+    env->width     = img.width;
+    env->height    = img.height;
+
+    float const *data = static_cast<float const *>(img.data);
+    env->texels.resize(static_cast<std::size_t>(img.width) * img.height);
+    for (std::size_t i = 0; i < env->texels.size(); i++)
+      env->texels[i] = vec3(data[i * 3 + 0], data[i * 3 + 1], data[i * 3 + 2]);
+
+    UnloadImage(img);
+
+    env->BuildDistribution();
+    return env;
+  }
+
+  void EnvironmentMap::BuildDistribution() {
+    conditionalCdf.assign(static_cast<std::size_t>(width + 1) * height, 0.0f);
+    rowWeights.assign(height, 0.0f);
+    marginalCdf.assign(height + 1, 0.0f);
+
+    for (int y = 0; y < height; y++) {
+      // Rows near the poles cover less solid angle than the ones at the horizon
+      float const sinTheta = std::sin(constants::pi * (y + 0.5f) / height);
+      float      *cdf      = &conditionalCdf[static_cast<std::size_t>(y) * (width + 1)];
+
+      for (int x = 0; x < width; x++) {
+        vec3 const c = Texel(x, y);
+        cdf[x + 1]   = cdf[x] + (0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z) * sinTheta;
+      }
+
+      rowWeights[y] = cdf[width];
+      if (rowWeights[y] > 0) {
+        for (int x = 1; x <= width; x++)
+          cdf[x] /= rowWeights[y];
+      }
+
+      marginalCdf[y + 1] = marginalCdf[y] + rowWeights[y];
+    }
+
+    totalWeight = marginalCdf[height];
+    if (totalWeight > 0) {
+      for (int y = 1; y <= height; y++)
+        marginalCdf[y] /= totalWeight;
+    }
+  }
+
+  void EnvironmentMap::DirectionToUV(vec3 const &direction, float &u, float &v) {
+    // Same mapping the old skysphere used (`Sphere::GetSphereUV` with u mirrored, since it's seen
+    // from the inside), so existing scenes keep their look
+    vec3 const  d     = direction.Normalize();
+    float const theta = std::acos(std::clamp(-d.y, -1.0f, 1.0f));
+    float const phi   = std::atan2(-d.z, d.x) + constants::pi;
+
+    u = 1.0f - phi / (2 * constants::pi);
+    v = theta / constants::pi;
+  }
+
+  vec3 EnvironmentMap::UVToDirection(float u, float v) {
+    float const theta    = v * constants::pi;
+    float const phi      = (1.0f - u) * 2 * constants::pi - constants::pi;
+    float const sinTheta = std::sin(theta);
+
+    return vec3(sinTheta * std::cos(phi), -std::cos(theta), -sinTheta * std::sin(phi));
+  }
+
+  vec3 EnvironmentMap::Radiance(vec3 const &direction) const {
+    float u, v;
+    DirectionToUV(direction, u, v);
+
+    // Bilinear, wrapping around horizontally and clamping at the poles
+    float const fx = u * width - 0.5f;
+    float const fy = std::clamp(v * height - 0.5f, 0.0f, static_cast<float>(height - 1));
+    int const   x0 = static_cast<int>(std::floor(fx));
+    int const   y0 = static_cast<int>(fy);
+    float const tx = fx - x0;
+    float const ty = fy - y0;
+
+    int const xa = ((x0 % width) + width) % width;
+    int const xb = (xa + 1) % width;
+    int const y1 = std::min(y0 + 1, height - 1);
+
+    vec3 const top    = Texel(xa, y0) * (1 - tx) + Texel(xb, y0) * tx;
+    vec3 const bottom = Texel(xa, y1) * (1 - tx) + Texel(xb, y1) * tx;
+    return (top * (1 - ty) + bottom * ty) * intensity;
+  }
+
+  float EnvironmentMap::PdfUV(float u, float v) const {
+    if (totalWeight <= 0)
+      return 0.0f;
+
+    int const x = std::clamp(static_cast<int>(u * width), 0, width - 1);
+    int const y = std::clamp(static_cast<int>(v * height), 0, height - 1);
+
+    float const sinTheta = std::sin(constants::pi * (y + 0.5f) / height);
+    vec3 const  c        = Texel(x, y);
+    float const weight   = (0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z) * sinTheta;
+
+    return weight / totalWeight * width * height;
+  }
+
+  EnvironmentMap::LightSample EnvironmentMap::Sample(float u1, float u2) const {
+    if (totalWeight <= 0)
+      return {vec3::Zero(), vec3::Zero(), 0.0f};
+
+    // Row from the marginal, then column from that row's conditional. The leftover fraction of
+    // each random number places the sample inside the texel.
+    auto const  rowIt = std::upper_bound(marginalCdf.begin(), marginalCdf.end(), u2);
+    int const   y     = std::clamp(static_cast<int>(rowIt - marginalCdf.begin()) - 1, 0, height - 1);
+    float const dy    = (u2 - marginalCdf[y]) / std::max(marginalCdf[y + 1] - marginalCdf[y], constants::epsilon);
+
+    auto const  cdfBegin = conditionalCdf.begin() + static_cast<std::ptrdiff_t>(y) * (width + 1);
+    auto const  colIt    = std::upper_bound(cdfBegin, cdfBegin + width + 1, u1);
+    int const   x        = std::clamp(static_cast<int>(colIt - cdfBegin) - 1, 0, width - 1);
+    float const dx       = (u1 - cdfBegin[x]) / std::max(cdfBegin[x + 1] - cdfBegin[x], constants::epsilon);
+
+    float const u = (x + std::clamp(dx, 0.0f, 1.0f)) / width;
+    float const v = (y + std::clamp(dy, 0.0f, 1.0f)) / height;
+
+    float const sinTheta = std::sin(v * constants::pi);
+    if (sinTheta <= 0)
+      return {vec3::Zero(), vec3::Zero(), 0.0f};
+
+    vec3 const direction = UVToDirection(u, v);
+
+    // Change of variables from the uv square to the sphere: dw = 2 pi^2 sin(theta) du dv
+    float const pdf = PdfUV(u, v) / (2 * constants::pi * constants::pi * sinTheta);
+
+    return {direction, Radiance(direction), pdf};
+  }
+
+  float EnvironmentMap::Pdf(vec3 const &direction) const {
+    float u, v;
+    DirectionToUV(direction, u, v);
+
+    float const sinTheta = std::sin(v * constants::pi);
+    if (sinTheta <= 0)
+      return 0.0f;
+
+    return PdfUV(u, v) / (2 * constants::pi * constants::pi * sinTheta);
+  }
+
+} // namespace rt
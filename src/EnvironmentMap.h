@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Defs.h"
+#include "data_structures/vec3.h"
+
+#include <string>
+#include <vector>
+
+namespace rt {
+
+  /**
+   * @brief Distant light surrounding the scene, stored as a lat-long (equirectangular) float image.
+   *
+   * Rays that escape the scene look their radiance up directly from their direction, no
+   * intersection involved. A 2D CDF over the texels (luminance weighted by the solid angle each
+   * row covers) lets diffuse hits sample directions towards the bright parts of the map.
+   * Works with both HDR (.hdr) and 8 bit images, the latter are mapped to [0, 1].
+   */
+  class EnvironmentMap {
+  public:
+    struct LightSample {
+      vec3  direction;
+      vec3  radiance;
+      float pdf; // Solid angle density, 0 if the sample is unusable
+    };
+
+    // Returns nullptr if the image can't be loaded
+    static sPtr<EnvironmentMap> Load(std::string const &path, float intensity = 1.0f);
+
+    vec3 Radiance(vec3 const &direction) const;
+
+    // Picks a direction proportionally to the map's brightness from two uniform numbers in [0, 1)
+    LightSample Sample(float u1, float u2) const;
+
+    // Solid angle density `Sample` picks `direction` with
+    float Pdf(vec3 const &direction) const;
+
+    std::string const &getPath() const { return path; }
+    float              getIntensity() const { return intensity; }
+    int                getWidth() const { return width; }
+    int                getHeight() const { return height; }
+
+    // Texels and sampling distribution
+    std::size_t memoryBytes() const {
+      return texels.size() * sizeof(vec3) +
+             (conditionalCdf.size() + marginalCdf.size() + rowWeights.size()) * sizeof(float);
+    }
+
+  private:
+    std::string path;
+    float       intensity = 1.0f;
+    int         width = 0, height = 0;
+
+    std::vector<vec3> texels; // Row major, row 0 is v = 0
+
+    // `conditionalCdf` holds one CDF of `width + 1` entries per row, `marginalCdf` picks the row.
+    // `rowWeights` and `totalWeight` are the unnormalized sums the CDFs were built from.
+    std::vector<float> conditionalCdf, marginalCdf, rowWeights;
+    float              totalWeight = 0.0f;
+
+    void BuildDistribution();
+
+    vec3 Texel(int x, int y) const { return texels[y * width + x]; }
+
+    // Pdf in uv space of the texel containing (u, v)
+    float PdfUV(float u, float v) const;
+
+    static void DirectionToUV(vec3 const &direction, float &u, float &v);
+    static vec3 UVToDirection(float u, float v);
+  };
+
+} // namespace rt
@@ -0,0 +1,191 @@
+#include "Headless.h"
+
+#include "AsyncRenderData.h"
+#include "Constants.h"
+#include "Ray.h"
+#include "RenderPool.h"
+#include "RenderProgress.h"
+#include "Scene.h"
+#include "SceneStats.h"
+#include "app.h"
+#include "output/Checkpoint.h"
+#include "output/ImageOutput.h"
+#include "output/ImageWriter.h"
+#include "output/TileStream.h"
+#include "textures/TileCache.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace rt {
+  namespace {
+    void PrintCounterRow(char const *label, RayCounters const &counters, long milliseconds) {
+      double const seconds = std::max(milliseconds, 1L) / 1000.0;
+      double const rays    = std::max(counters.rays(), 1L);
+
+      std::printf("%-8s %12ld %12ld %12ld %12.0f %9.2f %6.2f %10.1f %10.1f\n", label, counters.primaryRays,
+                  counters.secondaryRays, counters.shadowRays, counters.primaryRays / seconds,
+                  counters.rays() / seconds / 1e6, counters.averagePathDepth(), counters.nodesVisited / rays,
+                  counters.leafTests() / rays);
+    }
+
+    // The raytracer view's counters, per worker and in total
+    void PrintCounters(AsyncRenderData const &ard, long elapsedMs) {
+      std::printf("%-8s %12s %12s %12s %12s %9s %6s %10s %10s\n", "Thread", "Primary", "Secondary", "Shadow",
+                  "Samples/s", "Mrays/s", "Depth", "Nodes/ray", "Tests/ray");
+
+      for (size_t t = 0; t < ard.threadStats.size(); t++) {
+        ThreadStats const &stats = ard.threadStats[t];
+        PrintCounterRow(std::to_string(t).c_str(), stats.counters(), stats.time.load(std::memory_order_relaxed));
+      }
+
+      RayCounters const totals = ard.totalCounters();
+      PrintCounterRow("Total", totals, elapsedMs);
+
+      for (int t = 1; t < RayCounters::primitiveTypes; t++) {
+        if (totals.primitiveTests[t] > 0)
+          std::printf("%s: %ld tests, %ld hits (%.1f%%)\n", primitiveTypeLabels[t], totals.primitiveTests[t],
+                      totals.primitiveHits[t], 100.0 * totals.primitiveHits[t] / totals.primitiveTests[t]);
+      }
+
+      // Lets traversal orders be compared without a profiler, when perf events are permitted
+      long references = 0, misses = 0;
+      bool available  = false;
+      for (ThreadStats const &stats : ard.threadStats) {
+        if (!stats.cacheCountersAvailable.load(std::memory_order_relaxed))
+          continue;
+
+        available = true;
+        references += stats.cacheReferences.load(std::memory_order_relaxed);
+        misses += stats.cacheMisses.load(std::memory_order_relaxed);
+      }
+
+      if (available)
+        std::printf("Last-level cache: %ld misses of %ld references (%.1f%%)\n", misses, references,
+                    references > 0 ? 100.0 * misses / references : 0.0);
+      else
+        std::printf("Last-level cache: unavailable (perf events not permitted)\n");
+
+      std::fflush(stdout);
+    }
+  } // namespace
+
+  int RenderHeadless(CliConfig const &config) {
+    int const width = config.imageWidth, height = config.imageHeight;
+
+    Scene scene = config.pathToScene.empty() ? Scene::Earth(width, height)
+                                             : Scene::Load(width, height, config.pathToScene);
+
+    config.applyTo(scene.settings);
+
+    TileCache::Get().setBudget(std::size_t(config.textureBudgetMb) << 20);
+
+    bool const        streaming = config.streamOutput;
+    std::string const path      = !config.outputPath.empty()
+                                      ? config.outputPath
+                                      : TimestampedRenderPath(width, height, scene.settings.samplesPerPixel,
+                                                              scene.settings.maxDepth,
+                                                              streaming ? OutputFormat::exr : config.outputFormat);
+
+    // Only the tiles being rendered are kept in memory, finished ones are already in the file.
+    // Opened first so the framebuffer is built without planes.
+    sPtr<TileSink> stream;
+    if (streaming) {
+      stream = TiledExrStream::Open(path, width, height, constants::tileSize, FrameBuffer::PlaneCount(config.writeAovs));
+      if (!stream)
+        return 1;
+
+      if (!config.checkpointPath.empty() || !config.resumePath.empty())
+        std::cout << "WARNING: Checkpoints aren't supported when streaming, the output file holds the finished tiles\n";
+    }
+
+    // Declared before the pool so the workers are stopped before the buffers go away
+    AsyncRenderData ard(width, height, width, height, config.numThreads, 1, stream);
+    ImageWriter     writer;
+    RenderPool      pool(config.numThreads, config.pinThreads);
+
+    ard.changeNumThreads(config.numThreads, pool.numNodes());
+    ard.setTraversalOrder(scene.settings.traversalOrder);
+    ard.setAovs(config.writeAovs);
+    ard.reset();
+
+    // Tiles outside of the crop would be missing from the file
+    if (auto const region = scene.cropRegion(); region && streaming)
+      std::cout << "WARNING: Cropping isn't supported when streaming, rendering the whole image\n";
+    else if (region)
+      ard.restrictTo(*region, false);
+
+    if (config.printStats)
+      SceneStats::Collect(scene, &ard.frameBuffer).print(std::cout);
+
+    if (!config.resumePath.empty() && !streaming) {
+      auto checkpoint = LoadCheckpoint(config.resumePath);
+      if (!checkpoint || !RestoreCheckpoint(*checkpoint, ard, scene))
+        return 1;
+
+      std::cout << "Resumed " << checkpoint->finishedTiles() << " of " << ard.totalTiles() << " tiles from "
+                << config.resumePath << '\n';
+    }
+
+    auto handle = pool.submit([&ard, &scene, &pool](int threadIndex, CancellationToken const &token) {
+      Ray::Trace(ard, &scene, threadIndex, pool.nodeOf(threadIndex), token);
+    });
+
+    auto const     start          = std::chrono::steady_clock::now();
+    auto           lastCheckpoint = start;
+    RenderProgress progress;
+    progress.restart();
+
+    while (!handle.finished()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+      auto const now = std::chrono::steady_clock::now();
+      if (!streaming && !config.checkpointPath.empty() && now - lastCheckpoint >= std::chrono::seconds(config.checkpointInterval)) {
+        SubmitCheckpoint(writer, ard, scene, config.checkpointPath);
+        lastCheckpoint = now;
+      }
+
+      auto const estimate = progress.update(ard);
+      std::printf("\rTiles finished: %d / %d, %.2f Mrays/s", estimate.finishedTiles, estimate.totalTiles,
+                  estimate.mraysPerSecond);
+
+      // Padded, the line is rewritten in place and can get shorter
+      if (estimate.hasEta)
+        std::printf(", %s left (+/- %s)     ", RenderProgress::FormatSeconds(estimate.etaSeconds).c_str(),
+                    RenderProgress::FormatSeconds(estimate.etaErrSeconds).c_str());
+
+      std::fflush(stdout);
+    }
+
+    auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "\nRendered in " << elapsed.count() << " ms" << std::endl;
+    PrintCounters(ard, elapsed.count());
+
+    if (streaming) {
+      if (!ard.tileSink->ok()) {
+        std::cerr << "Failed to write some tiles to " << path << '\n';
+        return 1;
+      }
+
+      std::cout << "Wrote " << path << '\n';
+      return 0;
+    }
+
+    // Failed periodic checkpoints were reported when they happened, a later one replaces them
+    writer.drain();
+
+    if (!config.checkpointPath.empty())
+      SubmitCheckpoint(writer, ard, scene, config.checkpointPath);
+
+    writer.submit(path, config.outputFormat, Snapshot(ard.frameBuffer));
+
+    // Unattended runs only have the exit code to tell whether the render was saved
+    return writer.drain() ? 0 : 1;
+  }
+} // namespace rt
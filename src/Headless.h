@@ -0,0 +1,10 @@
+#pragma once
+
+struct CliConfig;
+
+namespace rt {
+  // Renders the configured scene without opening a window, then writes the image and exits.
+  // Prints progress to stdout and saves checkpoints as configured, for long renders on machines
+  // that may go away mid-render. Returns the process' exit code.
+  int RenderHeadless(CliConfig const &config);
+} // namespace rt
@@ -5,6 +5,7 @@
 #include "IRasterizable.h"
 #include "Ray.h"
 #include "Transformation.h"
+#include "data_structures/RayCounters.h"
 #include "data_structures/vec3.h"
 #include <cmath>
 #include <optional>
@@ -27,6 +28,11 @@ namespace rt {
     bool                 front_face;
     Hittable            *closestHit = nullptr;
 
+    // World space distance covered by one unit of uv, set by shapes that have a uv mapping.
+    // Zero means unknown, which always samples textures at full resolution.
+    float                uvScale   = 0.0f;
+    float                footprint = 0.0f; // Ray cone width at the hit in uv units
+
     inline void set_face_normal(const Ray &r, const vec3 &outward_normal) {
       front_face = Vector3DotProduct(outward_normal, r.direction) < 0;
       normal     = front_face ? outward_normal : outward_normal * -1;
@@ -39,7 +45,11 @@ namespace rt {
     Transformation transformation;
     sPtr<Material> material = nullptr; // Should only exist for raytracable objects
 
-    Hittable(std::string_view initialName) : name(initialName) {}
+    // Set by leaf shapes, only used to count intersection tests
+    PrimitiveType primitiveType;
+
+    Hittable(std::string_view initialName, PrimitiveType type = PrimitiveType::other)
+        : name(initialName), primitiveType(type) {}
 
     virtual bool Hit(const Ray &r, float t_min, float t_max, HitRecord &rec) const = 0;
     virtual bool BoundingBox(float t0, float t1, AABB &outputBox) const            = 0;
@@ -74,8 +84,18 @@ namespace rt {
       transformedRay.origin    = transformation.Inverse(r.origin);
       transformedRay.direction =  transformation.ApplyInverseRotation(r.direction);
 
-      if (!this->Hit(transformedRay, t_min, t_max, rec))
+      // `rec` is shared by every object a traversal tests. Only shapes with a uv mapping set a
+      // scale, the others mustn't keep the one of a farther hit, and a miss keeps the closer one.
+      float const previousUVScale = rec.uvScale;
+      rec.uvScale                 = 0.0f;
+
+      bool const hit = this->Hit(transformedRay, t_min, t_max, rec);
+      RayCounters::Local().countTest(primitiveType, hit);
+
+      if (!hit) {
+        rec.uvScale = previousUVScale;
         return false;
+      }
 
       rec.p = transformation.Apply(rec.p);
       rec.set_face_normal(transformedRay, transformation.ApplyRotation(rec.normal));
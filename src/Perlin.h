@@ -1,17 +1,30 @@
 #pragma once
 #include "Util.h"
 #include "data_structures/vec3.h"
+
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <type_traits>
+
 namespace rt {
+  /**
+   * @brief Gradient noise over a 256 entry lattice.
+   *
+   * Gradients are stored as three separate component arrays and permutations as bytes, all
+   * inline, so a Perlin object is a single ~3.8KB block without any pointer chasing. The 8
+   * corners of a lattice cell are evaluated as 8 SIMD lanes: only the gradient gathers are
+   * scalar, the weights, dot products and the sum are vectorized.
+   */
   class Perlin {
   public:
     Perlin() {
-
-      ranVec = new vec3[pointCount];
-
       for (int i = 0; i < pointCount; ++i) {
-        ranVec[i] = vec3::Random(-1, 1).Normalize();
+        vec3 gradient = vec3::Random(-1, 1).Normalize();
+        gradX[i]      = gradient.x;
+        gradY[i]      = gradient.y;
+        gradZ[i]      = gradient.z;
       }
 
       permX = PerlinGeneratePerm();
@@ -19,15 +32,57 @@ namespace rt {
       permZ = PerlinGeneratePerm();
     }
 
-    ~Perlin() {
-      delete[] ranVec;
-      delete[] permX;
-      delete[] permY;
-      delete[] permZ;
+    float Noise(const vec3 &p) const {
+      Corners corners;
+      Gather(p, 1.0f, corners, 0);
+
+      return Sum(corners, cornerCount);
     }
 
-    float Noise(const vec3 &p) const {
+    // Sums `depth` octaves, each at twice the frequency and half the weight of the previous one.
+    // All octaves' corners are gathered first and then reduced in one vectorized pass.
+    float Turb(const vec3 &p, int depth = 7) const {
+      float accum  = 0.0f;
+      float weight = 1.0f;
+      vec3  tempP  = p;
+
+      for (int first = 0; first < depth; first += maxBatchedOctaves) {
+        int const octaves = std::min(depth - first, maxBatchedOctaves);
+
+        Corners corners;
+        for (int o = 0; o < octaves; o++) {
+          Gather(tempP, weight, corners, o * cornerCount);
+          weight *= 0.5;
+          tempP *= 2;
+        }
+
+        accum += Sum(corners, octaves * cornerCount);
+      }
+
+      return fabs(accum);
+    }
 
+  private:
+    static const int pointCount        = 256;
+    static const int cornerCount       = 8;
+    static constexpr int maxBatchedOctaves = 8;
+
+    // Per-lane inputs of the interpolation, one lane per corner of each batched octave
+    struct Corners {
+      alignas(32) float gx[cornerCount * maxBatchedOctaves];
+      alignas(32) float gy[cornerCount * maxBatchedOctaves];
+      alignas(32) float gz[cornerCount * maxBatchedOctaves];
+      alignas(32) float dx[cornerCount * maxBatchedOctaves]; // Offset from the corner to the point
+      alignas(32) float dy[cornerCount * maxBatchedOctaves];
+      alignas(32) float dz[cornerCount * maxBatchedOctaves];
+      alignas(32) float weight[cornerCount * maxBatchedOctaves]; // Trilinear weight times octave weight
+    };
+
+    std::array<float, pointCount>        gradX, gradY, gradZ;
+    std::array<std::uint8_t, pointCount> permX, permY, permZ;
+
+    // Fills lanes [first, first + 8) with the cell corners around `p`
+    void Gather(const vec3 &p, float octaveWeight, Corners &c, int first) const {
       // Gets the fractional value of each coordinate
       float u = p.x - floor(p.x);
       float v = p.y - floor(p.y);
@@ -38,84 +93,49 @@ namespace rt {
       int j = floor(p.y);
       int k = floor(p.z);
 
-      vec3 c[2][2][2];
+      for (int corner = 0; corner < cornerCount; corner++) {
+        int const di = corner >> 2, dj = (corner >> 1) & 1, dk = corner & 1;
+        int const lane = first + corner;
 
-      for (int di = 0; di < 2; di++) {
-        for (int dj = 0; dj < 2; dj++) {
-          for (int dk = 0; dk < 2; dk++) {
-            // Hashing???
+        int const hashed = permX[(i + di) & 255] ^ permY[(j + dj) & 255] ^ permZ[(k + dk) & 255];
+        c.gx[lane]       = gradX[hashed];
+        c.gy[lane]       = gradY[hashed];
+        c.gz[lane]       = gradZ[hashed];
 
-            vec3 hashedVal =
-                ranVec[permX[(i + di) & 255] ^ permY[(j + dj) & 255] ^
-                       permZ[(k + dk) & 255]];
-            c[di][dj][dk] = hashedVal;
-          }
-        }
+        c.dx[lane] = u - di;
+        c.dy[lane] = v - dj;
+        c.dz[lane] = w - dk;
+
+        c.weight[lane] = octaveWeight * (di ? u : 1 - u) * (dj ? v : 1 - v) * (dk ? w : 1 - w);
       }
-      return PerlinInterp(c, u, v, w);
     }
 
-    float Turb(const vec3 &p, int depth = 7) const {
-      float accum  = 0.0f;
-      vec3  tempP  = p;
-      float weight = 1.0f;
+    static float Sum(Corners const &c, int lanes) {
+      float accum = 0.0f;
 
-      for (int i = 0; i < depth; i++) {
-        accum += weight * Noise(tempP);
-        weight *= 0.5;
-        tempP *= 2;
+#pragma omp simd reduction(+ : accum)
+      for (int lane = 0; lane < lanes; lane++) {
+        float dot = c.gx[lane] * c.dx[lane] + c.gy[lane] * c.dy[lane] + c.gz[lane] * c.dz[lane];
+        accum += c.weight[lane] * dot;
       }
 
-      return fabs(accum);
+      return accum;
     }
 
-  private:
-    static const int pointCount = 256;
-    vec3            *ranVec;
-    int             *permX;
-    int             *permY;
-    int             *permZ;
-
-    static int *PerlinGeneratePerm() {
-      auto *p = new int[pointCount];
+    static std::array<std::uint8_t, pointCount> PerlinGeneratePerm() {
+      std::array<std::uint8_t, pointCount> p;
       for (int i = 0; i < Perlin::pointCount; i++)
         p[i] = i;
 
-      Permute(p, pointCount);
+      Permute(p.data(), pointCount);
       return p;
     }
 
-    static void Permute(int *p, int n) {
+    static void Permute(std::uint8_t *p, int n) {
       for (int i = n - 1; i > 0; i--) {
         int target = RandomInt(0, i);
         std::swap(p[target], p[i]);
       }
     }
-
-    // u,v,w are the fractional part of a vec3's x,y,z coordinates
-    // c is a 3D matrix of (random?) values
-    static float PerlinInterp(vec3 c[2][2][2], float u, float v, float w) {
-
-      float uu    = u * u * (3 - 2 * u);
-      float vv    = v * v * (3 - 2 * v);
-      float ww    = w * w * (3 - 2 * w);
-      float accum = 0.0f;
-
-      for (int i = 0; i < 2; i++)
-        for (int j = 0; j < 2; j++)
-          for (int k = 0; k < 2; k++) {
-            vec3 weightV(u - i, v - j, w - k);
-
-            // clang-format off
-            // This looks like interpolation...
-            accum +=  (i * u + (1 - i) * (1 - u)) 
-                    * (j * v + (1 - j) * (1 - v)) 
-                    * (k * w + (1 - k) * (1 - w)) 
-                    * vec3::DotProd(c[i][j][k], weightV);
-
-            // clang-format on
-          }
-      return accum;
-    }
   };
-} // namespace rt
\ No newline at end of file
+} // namespace rt
@@ -1,21 +1,77 @@
 #include "Ray.h"
 
 #include "AsyncRenderData.h"
+#include "CacheCounters.h"
 #include "Camera.h"
 #include "Constants.h"
+#include "EnvironmentMap.h"
 #include "Hittable.h"
 #include "Scene.h"
+#include "TraceEvents.h"
 #include "Util.h"
+#include "data_structures/CancellationToken.h"
 #include "data_structures/JobQueue.h"
-#include "data_structures/Pixel.h"
+#include "data_structures/RayCounters.h"
 #include "materials/Material.h"
+#include "output/TileStream.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <iterator>
+#include <string>
 
 using std::chrono::high_resolution_clock, std::chrono::duration_cast;
 
 namespace rt {
-  vec3 Ray::RayColor(const rt::Ray &r, const Scene* scene, int depth) {
+  namespace {
+    // Multiple importance sampling weight of a sample drawn with density `pdf` when another
+    // strategy could have produced it with density `otherPdf`
+    float PowerHeuristic(float pdf, float otherPdf) {
+      float const a = pdf * pdf, b = otherPdf * otherPdf;
+      return a + b > 0 ? a / (a + b) : 0.0f;
+    }
+
+    // BVH nodes visited or leaf shapes tested for the camera ray `r`, or for its whole path
+    float TraversalCost(rt::Ray const &r, Scene const *scene) {
+      RayCounters      &counters = RayCounters::Local();
+      RayCounters const before   = counters;
+
+      if (scene->settings.heatmapFullPath) {
+        rt::Ray::RayColor(r, scene, scene->settings.maxDepth);
+      } else {
+        HitRecord rec;
+        counters.primaryRays++;
+        scene->worldRoot->Hit(r, 0.001f, rt::constants::infinity, rec);
+      }
+
+      return scene->settings.renderMode == RenderMode::nodeVisits ? counters.nodesVisited - before.nodesVisited
+                                                                  : counters.leafTests() - before.leafTests();
+    }
+
+    // Blue through green and yellow to red as `t` goes from 0 to 1, white above
+    vec3 HeatmapColor(float t) {
+      static vec3 const stops[] = {{0.0f, 0.0f, 0.3f}, {0.0f, 0.4f, 1.0f}, {0.0f, 0.9f, 0.3f},
+                                   {1.0f, 0.85f, 0.0f}, {1.0f, 0.0f, 0.0f}};
+      constexpr int     last    = std::size(stops) - 1;
+
+      vec3 color = vec3(1.0f);
+      if (t <= 1.0f) {
+        float const position = std::max(t, 0.0f) * last;
+        int const   i        = std::min(int(position), last - 1);
+        color                = stops[i] + (stops[i + 1] - stops[i]) * (position - i);
+      }
+
+#ifdef GAMMA_CORRECTION
+      // Undoes the correction applied on display, so the ramp shows as it's defined
+      color = color * color;
+#endif
+
+      return color;
+    }
+  } // namespace
+
+  vec3 Ray::RayColor(const rt::Ray &r, const Scene* scene, int depth, float scatterPdf, FrameBuffer::Aovs *aovs) {
     HitRecord rec;
 
     // Limit max recursion depth
@@ -23,67 +79,205 @@ namespace rt {
       return vec3::Zero();
     }
 
+    RayCounters &counters = RayCounters::Local();
+    if (depth == scene->settings.maxDepth)
+      counters.primaryRays++;
+    else
+      counters.secondaryRays++;
+
+    auto const &environment       = scene->environment;
+    bool const  sampleEnvironment = environment && scene->settings.sampleEnvironment;
+
     if (!scene->worldRoot->Hit(r, 0.001f, rt::constants::infinity, rec)) {
-      if (scene->skysphere)
-        scene->skysphere->Hit(r, -rt::constants::infinity, rt::constants::infinity, rec);
-      else
+      if (!environment)
         return scene->backgroundColor;
+
+      // The map was also sampled directly at the diffuse hit this ray left, weigh both estimates
+      vec3 radiance = environment->Radiance(r.direction);
+      if (sampleEnvironment && scatterPdf > 0)
+        radiance = radiance * PowerHeuristic(scatterPdf, environment->Pdf(r.direction));
+
+      return radiance;
+    }
+
+    // Project the ray cone onto the surface to get its width in texture space. Grazing angles
+    // stretch it along one axis only, the filter is isotropic so it takes the geometric mean of
+    // both axes: sizing it by the longer one blurs everything that isn't facing the camera.
+    // Clamped so silhouettes don't jump to the coarsest level.
+    float const coneWidth = r.ConeWidthAt(rec.t);
+    if (rec.uvScale > 0) {
+      float cosTheta = std::fabs(vec3::DotProd(r.direction.Normalize(), rec.normal));
+      rec.footprint  = coneWidth / (rec.uvScale * std::sqrt(std::max(cosTheta, 0.01f)));
     }
 
     rt::Ray scattered;
     vec3    attenuation;
-    vec3    emitted = rec.mat_ptr->emitted(rec.u, rec.v, rec.p);
+    vec3    emitted = rec.mat_ptr->emitted(rec.u, rec.v, rec.p, rec.footprint);
 
-    if (!rec.mat_ptr->scatter(r, rec, attenuation, scattered))
+    bool const scatters = rec.mat_ptr->scatter(r, rec, attenuation, scattered);
+
+    if (aovs) {
+      // Lights have no albedo to speak of, their color is the closest thing
+      aovs->albedo = scatters ? attenuation : emitted;
+      aovs->normal = rec.normal;
+      aovs->depth  = rec.t * r.direction.Len();
+    }
+
+    if (!scatters)
       return emitted;
 
-    return emitted + attenuation * RayColor(scattered, scene, depth - 1);
+    scattered.width  = coneWidth;
+    scattered.spread = rec.mat_ptr->scatterSpread(r.spread);
+
+    float const pdf = rec.mat_ptr->scatterPdf(rec, scattered.direction);
+
+    // Next event estimation: shoot a shadow ray towards a bright part of the environment
+    vec3 direct = vec3::Zero();
+    if (sampleEnvironment && pdf > 0) {
+      auto const  light    = environment->Sample(RandomFloat(), RandomFloat());
+      float const lightPdf = light.pdf;
+      float const matPdf   = lightPdf > 0 ? rec.mat_ptr->scatterPdf(rec, light.direction) : 0.0f;
+
+      if (matPdf > 0) {
+        counters.shadowRays++;
+
+        HitRecord shadowRec;
+        if (!scene->worldRoot->Hit(Ray(rec.p, light.direction, r.time), 0.001f, rt::constants::infinity, shadowRec)) {
+          // On the last bounce the scattered ray can't reach the map, so this gets the full weight
+          float const weight = depth > 1 ? PowerHeuristic(lightPdf, matPdf) : 1.0f;
+          direct             = attenuation * light.radiance * (matPdf * weight / lightPdf);
+        }
+      }
+    }
+
+    return emitted + direct + attenuation * RayColor(scattered, scene, depth - 1, pdf);
   }
 
-  void Ray::Trace(AsyncRenderData &ard, const Scene* scene, int threadIndex) {
+  void Ray::Trace(AsyncRenderData &ard, const Scene* scene, int threadIndex, int node, CancellationToken const &token) {
+    ThreadStats &stats = ard.threadStats[threadIndex];
+
+    // Streamed tiles are rendered into a tile-sized scratch buffer and handed to the sink, so the
+    // frame never has to fit in memory. Their y axis goes down, the way the output file stores them.
+    bool const  streaming = ard.tileSink != nullptr;
+    FrameBuffer scratch   = streaming ? FrameBuffer(rt::constants::tileSize, rt::constants::tileSize,
+                                                    rt::constants::tileSize, TraversalOrder::scanline,
+                                                    ard.frameBuffer.hasAovs())
+                                      : FrameBuffer();
+    FrameBuffer &fb       = streaming ? scratch : ard.frameBuffer;
+
+    float const pixelSpread = scene->cam.PixelSpread(scene->imageHeight);
+    bool const  heatmap     = scene->settings.renderMode != RenderMode::shaded;
+
+    // Set before the render is submitted and not changed while it runs
+    std::optional<Region> const &region = ard.region;
 
-    while (true) {
+    CacheCounters cacheCounters;
+    cacheCounters.start();
+
+    // Counted from zero every render, published with each finished tile
+    RayCounters::Local() = RayCounters();
+
+    TraceEvents::NameThread("Render worker " + std::to_string(threadIndex));
+
+    while (!token.isCancelled()) {
       auto start = high_resolution_clock::now();
-      auto [jobsStart, jobsEnd] = ard.pixelJobs->getChunk(ard, threadIndex);
+      bool stolen;
+      auto [jobsStart, jobsEnd] = ard.nextTiles(node, stolen);
+
+      // All jobs consumed
+      if (jobsStart == jobsEnd)
+        break;
 
       for (auto currentJob = jobsStart; currentJob != jobsEnd; ++currentJob) {
+        TraceScope const trace("Render tile");
+        auto const       tileStart = high_resolution_clock::now();
 
-#ifdef FAST_EXIT
-        // Exit prematurely if signaled to
-        if (ard.exit == true)
-          return;
-#endif
+        Tile const &tile = *currentJob;
+        Tile const  target = streaming ? Tile{0, 0, tile.width(), tile.height(), 0} : tile;
+        // Tiles crossing a region's edge keep their previous pixels outside of it
+        if (!region)
+          fb.clearTile(target);
+
+        // Seeded by position rather than tile index so the traversal order doesn't change the image
+        SeedRandom(HashSeed(scene->settings.seed, tile.x0, tile.y0));
+
+        int pixelsDone = 0;
 
-        Pixel      &job       = *currentJob;
+        for (auto [dx, dy] : ard.pixelOrder) {
+          // Partial tile at the image's edge
+          if (dx >= tile.width() || dy >= tile.height())
+            continue;
 
-        int x = job.x;
-        int y = job.y;
+          int const x     = tile.x0 + dx;
+          int const y     = streaming ? scene->imageHeight - 1 - (tile.y0 + dy) : tile.y0 + dy;
+          int const index = target.offset + dy * tile.width() + dx;
+
+          if (region && !region->contains(x, tile.y0 + dy))
+            continue;
+
+          vec3              color = vec3::Zero();
+          FrameBuffer::Aovs aovs;
+          float             cost = 0.0f;
 
           for (int s = 0; s < scene->settings.samplesPerPixel; s++) {
-          float   u   = (x + RandomFloat()) / (scene->imageWidth - 1);
-          float   v   = (y + RandomFloat()) / (scene->imageHeight - 1);
-          rt::Ray ray = scene->cam.GetRay(u, v);
-          job.color += rt::Ray::RayColor(ray, scene, scene->settings.maxDepth);
+            // Exit prematurely if signaled to, a single pixel can take seconds at high sample counts
+            if (token.isCancelled())
+              return;
+
+            float   u   = (x + RandomFloat()) / (scene->imageWidth - 1);
+            float   v   = (y + RandomFloat()) / (scene->imageHeight - 1);
+            rt::Ray ray = scene->cam.GetRay(u, v, pixelSpread);
+
+            // Heatmaps leave the AOVs empty
+            if (heatmap) {
+              cost += TraversalCost(ray, scene);
+            } else if (fb.hasAovs()) {
+              FrameBuffer::Aovs sample;
+              color += rt::Ray::RayColor(ray, scene, scene->settings.maxDepth, 0.0f, &sample);
+
+              aovs.albedo += sample.albedo;
+              aovs.normal += sample.normal;
+              aovs.depth += sample.depth;
+            } else {
+              color += rt::Ray::RayColor(ray, scene, scene->settings.maxDepth);
+            }
+          }
+
+          float const invSamples = 1.0f / scene->settings.samplesPerPixel;
+
+          // Gamma correction (if enabled) is applied when the buffer is displayed
+          fb.set(index, heatmap ? HeatmapColor(cost * invSamples / scene->settings.heatmapScale) : color * invSamples);
+
+          if (fb.hasAovs())
+            fb.setAovs(index, {aovs.albedo * invSamples, aovs.normal * invSamples, aovs.depth * invSamples});
+
+          // Publish progress once per tile row's worth of pixels
+          if (++pixelsDone % tile.width() == 0) {
+            stats.progress.store(pixelsDone * 100 / tile.pixelCount(), std::memory_order_relaxed);
+          }
         }
 
-#ifdef GAMMA_CORRECTION
-        // Gamma correction
-        float r = job.color.x, g = job.color.y, b = job.color.z;
+        if (streaming)
+          ard.tileSink->writeTile(tile, scratch);
 
-        float scale = 1.0 / scene->settings.samplesPerPixel;
-        r           = sqrt(scale * r);
-        g           = sqrt(scale * g);
-        b           = sqrt(scale * b);
+        float const tileMs = std::chrono::duration<float, std::milli>(high_resolution_clock::now() - tileStart).count();
+        ard.markFinished(tile, tileMs);
 
-        job.color = vec3(r, g, b);
-#else
-        job.color /= float(scene->settings.samplesPerPixel);
-#endif
-        ard.threadProgress[threadIndex] = ((float)(currentJob - jobsStart) / (jobsEnd - jobsStart)) * 100;
+        stats.tiles.fetch_add(1, std::memory_order_relaxed);
+        stats.publish(RayCounters::Local());
+        if (stolen)
+          stats.stolenTiles.fetch_add(1, std::memory_order_relaxed);
       }
-      auto stop                    = high_resolution_clock::now();
-      auto batchTime               = duration_cast<std::chrono::milliseconds>(stop - start).count();
-      ard.threadTimes[threadIndex] += batchTime;
+      auto stop      = high_resolution_clock::now();
+      auto batchTime = duration_cast<std::chrono::milliseconds>(stop - start).count();
+      stats.time.fetch_add(batchTime, std::memory_order_relaxed);
     }
+
+    cacheCounters.stop();
+    stats.cacheCountersAvailable.store(cacheCounters.available(), std::memory_order_relaxed);
+    stats.cacheReferences.store(cacheCounters.references(), std::memory_order_relaxed);
+    stats.cacheMisses.store(cacheCounters.misses(), std::memory_order_relaxed);
+
+    stats.finished.store(true, std::memory_order_release);
   }
 } // namespace rt
@@ -10,7 +10,7 @@ namespace rt {
   class Hittable;
   class Camera;
   class HittableList;
-  class Pixel;
+  class CancellationToken;
   class Scene;
 
   class Ray {
@@ -18,6 +18,10 @@ namespace rt {
     vec3  origin, direction;
     float time;
 
+    // Ray cone used to pick texture LODs: the cone is `width` wide at the origin and widens by
+    // `spread` per unit of distance travelled
+    float width = 0.0f, spread = 0.0f;
+
     Ray() = default;
     Ray(vec3 org, vec3 dir) : origin(org), direction(dir) {}
     Ray(vec3 org, vec3 dir, float time = 0.0)
@@ -25,12 +29,24 @@ namespace rt {
 
     vec3 At(float t) const { return Vector3Add(origin, direction * t); }
 
-    static vec3 RayColor(const rt::Ray &r, const Scene* scene, int depth);
+    // Width of the ray's cone at the point `At(t)`
+    float ConeWidthAt(float t) const { return width + spread * t * direction.Len(); }
+
+    // `scatterPdf` is the density the material `r` left from picked it with, 0 for camera rays and
+    // non diffuse bounces. Used to weigh environment hits against the environment samples.
+    // If `aovs` is set, the surface `r` hits first is written to it.
+    static vec3 RayColor(const rt::Ray &r, const Scene* scene, int depth, float scatterPdf = 0.0f,
+                         FrameBuffer::Aovs *aovs = nullptr);
 
+    // Renders tiles from `node`'s queue in `ard`, then steals from the other nodes' queues,
+    // until all are empty or the render is cancelled. Cancellation is checked before every sample.
+    // Pixels inside a tile are rendered in `ard.pixelOrder`.
     static void Trace(
       AsyncRenderData &ard,
       const Scene* scene,
-      int threadIndex
+      int threadIndex,
+      int node,
+      CancellationToken const &token
     );
 
   };
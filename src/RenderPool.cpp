@@ -0,0 +1,132 @@
+#include "RenderPool.h"
+#include "Topology.h"
+
+#include <algorithm>
+
+namespace rt {
+  RenderPool::RenderPool(int numThreads, bool pinThreads) : pinThreads(pinThreads) { spawnWorkers(numThreads); }
+
+  RenderPool::~RenderPool() {
+    cancelCurrent();
+    stopWorkers();
+  }
+
+  RenderHandle RenderPool::submit(Job job) {
+    // All workers have to be done with the previous job before a new one is published,
+    // otherwise a worker that didn't wake up in time would skip it and never report back.
+    cancelCurrent();
+
+    auto state = std::make_shared<JobState>(std::move(job), size());
+    {
+      std::lock_guard<std::mutex> lk{poolMutex};
+      current = state;
+      generation++;
+    }
+    wakeWorkers.notify_all();
+
+    return RenderHandle(state);
+  }
+
+  void RenderPool::resize(int numThreads) {
+    cancelCurrent();
+    stopWorkers();
+    spawnWorkers(numThreads);
+  }
+
+  void RenderPool::pinWorker(int threadIndex) {
+    auto const &node = Topology::get().getNodes()[nodeOf(threadIndex)];
+
+    // Workers of a node fill its CPUs one by one, wrapping around if there are more workers than CPUs
+    int const cpu = node.cpus[(threadIndex / nodeCount) % node.cpus.size()];
+    Topology::pinCurrentThread(cpu);
+  }
+
+  void RenderPool::spawnWorkers(int numThreads) {
+    std::lock_guard<std::mutex> lk{poolMutex};
+    stopping = false;
+
+    // Nodes without a worker would only ever have their tiles stolen
+    nodeCount = pinThreads ? std::clamp((int)Topology::get().getNodes().size(), 1, std::max(numThreads, 1)) : 1;
+
+    for (int t = 0; t < numThreads; t++) {
+      workers.emplace_back(&RenderPool::workerLoop, this, t, generation);
+    }
+  }
+
+  void RenderPool::stopWorkers() {
+    {
+      std::lock_guard<std::mutex> lk{poolMutex};
+      stopping = true;
+    }
+    wakeWorkers.notify_all();
+
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    workers.clear();
+  }
+
+  void RenderPool::cancelCurrent() {
+    RenderHandle previous;
+    {
+      std::lock_guard<std::mutex> lk{poolMutex};
+      previous = RenderHandle(current);
+    }
+
+    previous.cancelAndWait();
+  }
+
+  void RenderPool::workerLoop(int threadIndex, std::uint64_t seenGeneration) {
+    if (pinThreads)
+      pinWorker(threadIndex);
+
+    while (true) {
+      sPtr<JobState> state;
+      {
+        std::unique_lock<std::mutex> lk{poolMutex};
+        wakeWorkers.wait(lk, [&] { return stopping || generation != seenGeneration; });
+
+        if (stopping)
+          return;
+
+        seenGeneration = generation;
+        state          = current;
+      }
+
+      state->job(threadIndex, state->token);
+
+      std::lock_guard<std::mutex> lk{state->doneMutex};
+      if (--state->remainingWorkers == 0)
+        state->doneCondition.notify_all();
+    }
+  }
+
+  void RenderHandle::cancel() const {
+    if (state)
+      state->token.cancel();
+  }
+
+  bool RenderHandle::isCancelled() const { return state && state->token.isCancelled(); }
+
+  void RenderHandle::cancelAndWait() const {
+    cancel();
+    wait();
+  }
+
+  bool RenderHandle::finished() const {
+    if (!state)
+      return true;
+
+    std::lock_guard<std::mutex> lk{state->doneMutex};
+    return state->remainingWorkers == 0;
+  }
+
+  void RenderHandle::wait() const {
+    if (!state)
+      return;
+
+    std::unique_lock<std::mutex> lk{state->doneMutex};
+    state->doneCondition.wait(lk, [this] { return state->remainingWorkers == 0; });
+  }
+} // namespace rt
@@ -0,0 +1,110 @@
+#pragma once
+#include "Defs.h"
+#include "data_structures/CancellationToken.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rt {
+  class RenderHandle;
+
+  /**
+   * @brief Long-lived set of render workers.
+   *
+   * Workers are spawned once and sleep between renders. A submitted job is run once on every
+   * worker (with the worker's index), and is observed and cancelled through the returned handle.
+   * Jobs are expected to poll the cancellation token they're given and return once it's set.
+   * Only one job runs at a time, submitting a new one cancels and waits for the previous one.
+   *
+   * With pinning enabled, workers are spread round-robin over the NUMA nodes and each is pinned
+   * to one CPU of its node, so `nodeOf` tells a job which node's memory is local to a worker.
+   */
+  class RenderPool {
+  public:
+    using Job = std::function<void(int threadIndex, CancellationToken const &token)>;
+
+    explicit RenderPool(int numThreads, bool pinThreads = false);
+    ~RenderPool();
+
+    RenderPool(RenderPool const &)            = delete;
+    RenderPool &operator=(RenderPool const &) = delete;
+
+    RenderHandle submit(Job job);
+
+    // Cancels the running job (if any) and respawns the workers
+    void resize(int numThreads);
+
+    int size() const { return workers.size(); }
+
+    // Number of NUMA nodes workers are spread over, 1 without pinning
+    int numNodes() const { return nodeCount; }
+    int nodeOf(int threadIndex) const { return threadIndex % nodeCount; }
+
+  private:
+    struct JobState;
+
+    void spawnWorkers(int numThreads);
+    void stopWorkers();
+    void cancelCurrent();
+    void workerLoop(int threadIndex, std::uint64_t seenGeneration);
+    void pinWorker(int threadIndex);
+
+    std::vector<std::thread> workers;
+    bool                     pinThreads;
+    int                      nodeCount = 1;
+
+    std::mutex              poolMutex;
+    std::condition_variable wakeWorkers;
+
+    sPtr<JobState> current;
+    std::uint64_t  generation = 0;
+    bool           stopping   = false;
+
+    friend class RenderHandle;
+  };
+
+  /**
+   * @brief Shared view of a submitted render job. A default constructed handle refers to no
+   * job and is always finished.
+   */
+  class RenderHandle {
+  public:
+    RenderHandle() = default;
+
+    // Asks the workers to stop, returns immediately
+    void cancel() const;
+    bool isCancelled() const;
+
+    // Cancels and blocks until every worker returned
+    void cancelAndWait() const;
+
+    // Whether every worker returned from the job
+    bool finished() const;
+
+    // Blocks until every worker returned from the job
+    void wait() const;
+
+  private:
+    explicit RenderHandle(sPtr<RenderPool::JobState> state) : state(std::move(state)) {}
+
+    sPtr<RenderPool::JobState> state;
+
+    friend class RenderPool;
+  };
+
+  struct RenderPool::JobState {
+    Job               job;
+    CancellationToken token;
+
+    std::mutex              doneMutex;
+    std::condition_variable doneCondition;
+    int                     remainingWorkers;
+
+    JobState(Job job, int numWorkers) : job(std::move(job)), remainingWorkers(numWorkers) {}
+  };
+} // namespace rt
@@ -0,0 +1,89 @@
+#include "RenderProgress.h"
+
+#include "AsyncRenderData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace rt {
+  void RenderProgress::restart() {
+    samples.clear();
+    samples.push_back({Clock::now(), 0});
+  }
+
+  RenderProgress::Estimate RenderProgress::update(AsyncRenderData const &ard) {
+    Estimate estimate;
+    estimate.totalTiles = ard.totalTiles();
+
+    double sum = 0, sumSquares = 0;
+    for (int i = 0; i < estimate.totalTiles; i++) {
+      if (!ard.isFinished(i))
+        continue;
+
+      estimate.finishedTiles++;
+
+      // Skipped tiles cost nothing and say nothing about the others
+      float const cost = ard.tileCost(i);
+      if (cost <= 0)
+        continue;
+
+      estimate.renderedTiles++;
+      estimate.tileCostMax = std::max(estimate.tileCostMax, double(cost));
+      sum += cost;
+      sumSquares += double(cost) * cost;
+    }
+
+    // Counters are published once per tile, the window smooths out the steps
+    auto const now = Clock::now();
+    samples.push_back({now, ard.totalCounters().rays()});
+    while (samples.size() > 2 && now - samples[1].time >= rateWindow) {
+      samples.pop_front();
+    }
+
+    double const windowSeconds = std::chrono::duration<double>(now - samples.front().time).count();
+    if (windowSeconds > 0)
+      estimate.mraysPerSecond = (samples.back().rays - samples.front().rays) / windowSeconds / 1e6;
+
+    int const workers   = std::max<int>(ard.threadStats.size(), 1);
+    int const remaining = estimate.totalTiles - estimate.finishedTiles;
+
+    // The first round of tiles is still running until every worker finished one
+    if (estimate.renderedTiles == 0 || estimate.renderedTiles < std::min(workers, estimate.renderedTiles + remaining))
+      return estimate;
+
+    int const    n        = estimate.renderedTiles;
+    double const mean     = sum / n;
+    double const variance = n > 1 ? std::max(0.0, (sumSquares - sum * mean) / (n - 1)) : 0.0;
+
+    estimate.tileCostMean = mean;
+    estimate.hasEta       = true;
+
+    // The remaining tiles are shared by the workers until there are fewer of them than workers,
+    // and the last one takes a whole tile's time on its own. Tiles in flight count as
+    // remaining, which overestimates by at most one tile. Costs of the remaining tiles add up,
+    // so does their variance. Coherent traversal orders render neighbouring tiles together, the
+    // spread only covers the variance seen so far.
+    int const busyWorkers = std::min(workers, remaining);
+    if (busyWorkers > 0) {
+      estimate.etaSeconds    = std::max(remaining * mean / busyWorkers, mean) / 1000.0;
+      estimate.etaErrSeconds = 1.96 * std::sqrt(variance * remaining) / busyWorkers / 1000.0;
+    }
+
+    return estimate;
+  }
+
+  std::string RenderProgress::FormatSeconds(double seconds) {
+    char       text[32];
+    long const whole = std::lround(seconds);
+
+    if (whole >= 3600)
+      std::snprintf(text, sizeof(text), "%ldh %02ldm", whole / 3600, whole / 60 % 60);
+    else if (whole >= 60)
+      std::snprintf(text, sizeof(text), "%ldm %02lds", whole / 60, whole % 60);
+    else
+      std::snprintf(text, sizeof(text), "%.1fs", seconds);
+
+    return text;
+  }
+} // namespace rt
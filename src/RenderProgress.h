@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+
+namespace rt {
+  struct AsyncRenderData;
+
+  /**
+   * @brief Completed work, throughput and time left of a running render, for progress displays.
+   *
+   * Sampled from the thread showing the progress, it only reads what the workers publish. The
+   * estimate is built from the tiles rendered so far: their mean cost gives the expected time
+   * left, their variance how far off that can be.
+   */
+  class RenderProgress {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Estimate {
+      int    finishedTiles  = 0; // Including the tiles skipped by a crop or resume
+      int    totalTiles     = 0;
+      double mraysPerSecond = 0; // Over the last `rateWindow`
+
+      // Worker time per rendered tile, in ms
+      int    renderedTiles = 0;
+      double tileCostMean  = 0;
+      double tileCostMax   = 0;
+
+      // Wall time left, and the half width of its ~95% interval. Not known until every worker
+      // finished a tile.
+      bool   hasEta        = false;
+      double etaSeconds    = 0;
+      double etaErrSeconds = 0;
+
+      float fraction() const { return totalTiles > 0 ? float(finishedTiles) / totalTiles : 0.0f; }
+    };
+
+    // Throughput is averaged over this much wall time
+    static constexpr std::chrono::seconds rateWindow{2};
+
+    // Call when the render is submitted, the rates are measured from here
+    void restart();
+
+    // Reads the render's current state, call as often as it's displayed
+    Estimate update(AsyncRenderData const &ard);
+
+    // "1h 05m", "3m 12s" or "8.4s"
+    static std::string FormatSeconds(double seconds);
+
+  private:
+    struct Sample {
+      Clock::time_point time;
+      long              rays;
+    };
+
+    std::deque<Sample> samples; // Oldest first, spanning about `rateWindow`
+  };
+} // namespace rt
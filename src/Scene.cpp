@@ -6,6 +6,7 @@
 #include "HittableBuilder.h"
 #include "HittableList.h"
 #include "Ray.h"
+#include "TraceEvents.h"
 #include "Transformation.h"
 #include "Util.h"
 #include "data_structures/vec3.h"
@@ -51,26 +52,30 @@ namespace rt {
       {"Plane test", PlaneTest},
       {"Raster test", RasterTest}};
 
-  void Scene::addSkysphere(std::string ssTex) {
-
-    skysphereTexture = ssTex;
-
-    auto tex = std::make_shared<ImageTexture>(ssTex.c_str(), false, true);
+  void Scene::setEnvironment(std::string path, float intensity) {
+    environment            = EnvironmentMap::Load(path, intensity);
+    environmentModelLoaded = false;
+  }
 
-    auto skysphereMat = std::make_shared<DiffuseLight>(tex);
-    skysphere         = std::make_shared<Sphere>(500.0f, skysphereMat);
+  void Scene::drawEnvironment(vec3 position) {
+    if (!environmentModelLoaded) {
+      // 8 bit is plenty for a preview, HDR maps just get clipped
+      ::Image img = LoadImage(environment->getPath().c_str());
+      if (img.data == nullptr)
+        img = GenImageColor(1, 1, BLACK);
+      ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+      ImageFlipVertical(&img);
 
-    ::Image img = LoadImage(skysphereTexture.c_str());
-    ImageFlipVertical(&img);
+      environmentModel = LoadModelFromMesh(EditorUtils::generateSkysphere(500, {32, 32}));
+      environmentModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = LoadTextureFromImage(img);
+      UnloadImage(img);
 
-    skysphereModel = LoadModelFromMesh(EditorUtils::generateSkysphere(500, {32, 32}));
-    skysphereModel.materials[0].maps[MATERIAL_MAP_DIFFUSE].texture = LoadTextureFromImage(img);
-  }
+      environmentModelLoaded = true;
+    }
 
-  void Scene::drawSkysphere() {
     rlDisableBackfaceCulling();
     rlDisableDepthMask();
-    DrawModel(skysphereModel, skysphere->transformation.getTranslation(), 1.0f, WHITE);
+    DrawModel(environmentModel, position, 1.0f, WHITE);
     rlEnableDepthMask();
     rlEnableBackfaceCulling();
   }
@@ -522,7 +527,10 @@ namespace rt {
     std::cout << "Loading scene from file " << path << '\n';
 
     json readScene;
-    jsonFile >> readScene;
+    {
+      TraceScope const trace("Parse scene");
+      jsonFile >> readScene;
+    }
 
     json  settings    = readScene["settings"];
     float aspectRatio = (float)imageWidth / imageHeight;
@@ -536,14 +544,39 @@ namespace rt {
         settings["background_color"].get<vec3>()
     );
 
+    // Optional, scenes saved before it was added render in scanline order
+    if (settings.contains("traversal_order")) {
+      auto const order = settings["traversal_order"].get<std::string>();
+      for (int i = 0; i < static_cast<int>(TraversalOrder::traversalOrdersCount); i++) {
+        if (order == traversalOrderLabels[i])
+          s.settings.traversalOrder = static_cast<TraversalOrder>(i);
+      }
+    }
+
+    if (settings.contains("sample_environment"))
+      s.settings.sampleEnvironment = settings["sample_environment"].get<bool>();
+
+    if (settings.contains("seed"))
+      s.settings.seed = settings["seed"].get<std::uint32_t>();
+
+    if (readScene.contains("environment")) {
+      json const &env = readScene["environment"];
+      s.setEnvironment(env["path"].get<std::string>(), env.value("intensity", 1.0f));
+    }
+
     auto world = HittableList();
 
     std::cout << std::setw(4) << readScene["objects"] << '\n';
-    for (const auto &obj : readScene["objects"]) {
+    {
+      // Includes decoding their textures
+      TraceScope const trace("Load objects");
 
-      auto objPtr = ObjectFactory::FromJson(obj);
-      if (objPtr)
-        world.Add(objPtr);
+      for (const auto &obj : readScene["objects"]) {
+
+        auto objPtr = ObjectFactory::FromJson(obj);
+        if (objPtr)
+          world.Add(objPtr);
+      }
     }
 
     std::cout << "Loaded scene with\n"
@@ -589,7 +622,7 @@ namespace rt {
     std::vector<sPtr<Hittable>> world = {box, sphere};
 
     s = Scene(new BVHNode(world, 0, 1), cam, imageWidth, imageHeight, backgroundColor);
-    s.addSkysphere(skyspherePath);
+    s.setEnvironment(skyspherePath);
 
     return s;
   }
@@ -672,6 +705,21 @@ namespace rt {
     return objJsons;
   }
 
+  std::optional<Region> Scene::cropRegion() const {
+    if (!settings.crop)
+      return std::nullopt;
+
+    auto const  &rect = settings.cropRegion;
+    Region const region =
+        Region::FromImage(rect[0], rect[1], rect[2], rect[3], imageHeight).clamped(imageWidth, imageHeight);
+
+    // Rendering nothing is never what's meant
+    if (region.empty())
+      return std::nullopt;
+
+    return region;
+  }
+
   json Scene::toJson() const {
     json sceneJson;
     to_json(sceneJson, *this);
@@ -1,19 +1,59 @@
 #pragma once
 #include "Camera.h"
 #include "Defs.h"
+#include "EnvironmentMap.h"
 #include "IImguiDrawable.h"
+#include "data_structures/Region.h"
+#include "data_structures/RenderMode.h"
+#include "data_structures/TraversalOrder.h"
 
 #include <nlohmann-json/json.hpp>
 #include <raylib.h>
 #include <raymath.h>
 #include <imgui.h>
 
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <vector>
 
 struct RaytraceSettings : public rt::IImguiDrawable {
   int samplesPerPixel = 1;
   int maxDepth        = 10;
 
+  // Applied to both the order tiles are handed out in and the order of pixels inside a tile
+  rt::TraversalOrder traversalOrder = rt::TraversalOrder::scanline;
+
+  // Importance sample the environment map at diffuse hits instead of waiting for rays to escape
+  bool sampleEnvironment = true;
+
+  // Every tile's random sequence starts from this, so renders (and resumed renders) are repeatable
+  std::uint32_t seed = 0;
+
+  // Only render this rectangle (left, top, right, bottom in pixels from the image's top left
+  // corner), the rest of the image keeps the previous render. Not saved with the scene.
+  bool crop          = false;
+  int  cropRegion[4] = {0, 0, 0, 0};
+
+  // Only render the screen area of objects that changed since the last complete render
+  bool onlyChanges = false;
+
+  // Debug views of where traversal time goes, not saved with the scene either. Heatmaps count
+  // the camera ray's work, or the whole path's if `heatmapFullPath`, and color `heatmapScale`
+  // nodes or tests (per sample) at the top of the ramp, anything above in white.
+  rt::RenderMode renderMode      = rt::RenderMode::shaded;
+  bool           heatmapFullPath = false;
+  float          heatmapScale    = 64.0f;
+
+  // Empty for shaded renders, describes the heatmap otherwise
+  std::string debugViewDescription() const {
+    if (renderMode == rt::RenderMode::shaded)
+      return "";
+
+    return std::string(rt::renderModeNames[static_cast<int>(renderMode)]) + (heatmapFullPath ? " full path " : " ") +
+           std::to_string(heatmapScale);
+  }
+
   RaytraceSettings() = default;
   RaytraceSettings(int spp, int md) : samplesPerPixel(spp), maxDepth(md) {}
 
@@ -21,6 +61,20 @@ struct RaytraceSettings : public rt::IImguiDrawable {
     ImGui::Begin("Raytrace settings");
     ImGui::DragInt("Samples per pixel", &samplesPerPixel, 1, 1, 500);
     ImGui::DragInt("Maximum depth", &maxDepth, 1, 1, 100);
+    ImGui::Combo("Traversal order", (int *)&traversalOrder, rt::traversalOrderLabels,
+                 static_cast<int>(rt::TraversalOrder::traversalOrdersCount));
+    ImGui::Checkbox("Sample environment", &sampleEnvironment);
+    ImGui::InputScalar("Seed", ImGuiDataType_U32, &seed);
+    ImGui::Checkbox("Crop", &crop);
+    if (crop)
+      ImGui::DragInt4("Crop region", cropRegion, 1, 0, 16384);
+    ImGui::Checkbox("Only render changes", &onlyChanges);
+    ImGui::Combo("Render mode", (int *)&renderMode, rt::renderModeLabels,
+                 static_cast<int>(rt::RenderMode::renderModesCount));
+    if (renderMode != rt::RenderMode::shaded) {
+      ImGui::Checkbox("Heatmap of the full path", &heatmapFullPath);
+      ImGui::DragFloat("Heatmap scale", &heatmapScale, 1.0f, 1.0f, 10000.0f);
+    }
     ImGui::End();
   }
 };
@@ -44,10 +98,12 @@ namespace rt {
     */
     Hittable *worldRoot;
 
-    sPtr<Hittable> skysphere;
+    // Lights rays escaping the scene, `backgroundColor` is used when there's none
+    sPtr<EnvironmentMap> environment;
 
-    std::string skysphereTexture;
-    ::Model     skysphereModel;
+    // Editor preview of the environment, created on first draw so headless renders need no GL context
+    ::Model environmentModel;
+    bool    environmentModelLoaded = false;
 
     Camera cam;
     int    imageWidth, imageHeight;
@@ -65,9 +121,13 @@ namespace rt {
     Scene(Hittable *wr, Camera c, int iw, int ih, vec3 bc)
         : worldRoot(wr), cam(c), imageWidth(iw), imageHeight(ih), backgroundColor(bc) {}
 
-    void addSkysphere(std::string ssTex);
+    void setEnvironment(std::string path, float intensity = 1.0f);
 
-    void drawSkysphere();
+    // The crop rectangle in framebuffer space, if cropping is enabled and it covers any pixels
+    std::optional<Region> cropRegion() const;
+
+    // Draws the environment preview centered on `position` (the editor camera), so it never gets closer
+    void drawEnvironment(vec3 position);
 
     static Scene Default(int imageWidth, int imageHeight);
 
@@ -107,8 +167,14 @@ namespace rt {
                        {"background_color", s.backgroundColor},
                        {"num_samples", s.settings.samplesPerPixel},
                        {"max_depth", s.settings.maxDepth},
+                       {"traversal_order", rt::traversalOrderLabels[static_cast<int>(s.settings.traversalOrder)]},
+                       {"sample_environment", s.settings.sampleEnvironment},
+                       {"seed", s.settings.seed},
          }},
         s.cam,
         {"objects", objArr}};
+
+    if (s.environment)
+      j["environment"] = {{"path", s.environment->getPath()}, {"intensity", s.environment->getIntensity()}};
   }
 } // namespace rt
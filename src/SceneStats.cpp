@@ -0,0 +1,192 @@
+#include "SceneStats.h"
+
+#include "BVHNode.h"
+#include "EnvironmentMap.h"
+#include "HittableList.h"
+#include "Scene.h"
+#include "data_structures/FrameBuffer.h"
+#include "objects/AARect.h"
+#include "objects/Box.h"
+#include "objects/MovingSphere.h"
+#include "objects/Plane.h"
+#include "objects/Sphere.h"
+#include "objects/Triangle.h"
+#include "textures/TextureCache.h"
+#include "textures/TileCache.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace rt {
+  namespace {
+    template <typename... Types> bool IsAny(Hittable const *object) {
+      return ((dynamic_cast<Types const *>(object) != nullptr) || ...);
+    }
+
+    // Size of the object and whatever it owns, shared materials and textures excluded
+    std::size_t ObjectBytes(Hittable const *object) {
+      if (auto const *box = dynamic_cast<Box const *>(object)) {
+        std::size_t bytes = sizeof(Box) + box->sides.objects.capacity() * sizeof(sPtr<Hittable>);
+        for (auto const &side : box->sides.objects) {
+          bytes += ObjectBytes(side.get());
+        }
+
+        return bytes;
+      }
+
+      if (auto const *list = dynamic_cast<HittableList const *>(object)) {
+        std::size_t bytes = sizeof(HittableList) + list->objects.capacity() * sizeof(sPtr<Hittable>);
+        for (auto const &child : list->objects) {
+          bytes += ObjectBytes(child.get());
+        }
+
+        return bytes;
+      }
+
+      if (IsAny<Sphere>(object))
+        return sizeof(Sphere);
+      if (IsAny<MovingSphere>(object))
+        return sizeof(MovingSphere);
+      if (IsAny<Triangle>(object))
+        return sizeof(Triangle);
+      if (IsAny<XYRect, XZRect, YZRect>(object))
+        return sizeof(XYRect);
+      if (IsAny<Plane>(object))
+        return sizeof(Plane);
+
+      return sizeof(Hittable);
+    }
+
+    float SurfaceArea(AABB const &box) {
+      vec3 const d = box.max - box.min;
+      return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    // Walks the tree below `node`, `depth` counting `node` itself
+    void CollectBvh(BVHNode const *node, int depth, float rootArea, SceneStats &stats) {
+      stats.bvhNodes++;
+      stats.bvhBytes += sizeof(BVHNode);
+      stats.bvhDepth = std::max(stats.bvhDepth, depth);
+
+      // Both children are always tested, a node holding a single object tests it twice
+      int objectTests = 0;
+      for (auto const &child : {node->left, node->right}) {
+        if (auto const *inner = dynamic_cast<BVHNode const *>(child.get()))
+          CollectBvh(inner, depth + 1, rootArea, stats);
+        else if (child)
+          objectTests++;
+      }
+
+      if (objectTests > 0) {
+        stats.bvhLeaves++;
+        stats.leafSizes[node->left == node->right ? 1 : objectTests]++;
+      }
+
+      // Node visits and object tests of a ray crossing the root's box, both costing 1
+      if (rootArea > 0)
+        stats.sahCost += SurfaceArea(node->box) / rootArea * (1 + objectTests);
+    }
+
+    // "512 B", "12.3 KiB", "1.50 GiB"...
+    std::string FormatBytes(std::size_t bytes) {
+      char const *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+
+      double value = bytes;
+      int    unit  = 0;
+      while (value >= 1024 && unit < 4) {
+        value /= 1024;
+        unit++;
+      }
+
+      char text[32];
+      std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.2f %s", value, units[unit]);
+      return text;
+    }
+  } // namespace
+
+  SceneStats SceneStats::Collect(Scene const &scene, FrameBuffer const *frameBuffer) {
+    SceneStats stats;
+
+    for (auto const &object : scene.worldRoot->getChildrenAsList()) {
+      stats.objects++;
+      stats.objectTypes[object->toJsonSpecific().value("type", "unknown")]++;
+      stats.geometryBytes += ObjectBytes(object.get());
+    }
+
+    if (auto const *root = dynamic_cast<BVHNode const *>(scene.worldRoot))
+      CollectBvh(root, 1, SurfaceArea(root->box), stats);
+
+    stats.textureBytes = TextureCache::ResidentBytes() + TileCache::Get().stats().residentBytes;
+
+    if (scene.environment)
+      stats.environmentBytes = scene.environment->memoryBytes();
+
+    if (frameBuffer)
+      stats.frameBufferBytes = frameBuffer->residentBytes();
+
+    return stats;
+  }
+
+  void SceneStats::print(std::ostream &out) const {
+    out << "Scene statistics\n";
+    out << "  Objects: " << objects;
+    for (char const *separator = " ("; auto const &[type, count] : objectTypes) {
+      out << separator << type << ": " << count;
+      separator = ", ";
+    }
+    out << (objectTypes.empty() ? "" : ")") << '\n';
+
+    if (bvhNodes > 0) {
+      // Formatted apart so the caller's stream (usually std::cout) keeps its own precision
+      char cost[32];
+      std::snprintf(cost, sizeof(cost), "%.2f", sahCost);
+
+      out << "  BVH: " << bvhNodes << " nodes, " << bvhLeaves << " leaves, depth " << bvhDepth << ", SAH cost "
+          << cost << '\n';
+
+      out << "  Leaves:";
+      for (char const *separator = " "; auto const &[size, count] : leafSizes) {
+        out << separator << count << " with " << size << (size == 1 ? " object" : " objects");
+        separator = ", ";
+      }
+      out << '\n';
+    }
+
+    out << "  Memory: " << FormatBytes(totalBytes()) << '\n';
+    out << "    Geometry:     " << FormatBytes(geometryBytes) << '\n';
+    out << "    BVH:          " << FormatBytes(bvhBytes) << '\n';
+    out << "    Textures:     " << FormatBytes(textureBytes) << '\n';
+    out << "    Environment:  " << FormatBytes(environmentBytes) << '\n';
+    out << "    Framebuffers: " << FormatBytes(frameBufferBytes) << '\n';
+  }
+
+  void SceneStats::OnImgui() const {
+    ImGui::Text("Objects: %d", objects);
+    for (auto const &[type, count] : objectTypes) {
+      ImGui::BulletText("%s: %d", type.c_str(), count);
+    }
+
+    ImGui::Separator();
+
+    if (bvhNodes > 0) {
+      ImGui::Text("BVH: %d nodes, %d leaves, depth %d", bvhNodes, bvhLeaves, bvhDepth);
+      ImGui::Text("SAH cost: %.2f", sahCost);
+      for (auto const &[size, count] : leafSizes) {
+        ImGui::BulletText("Leaves with %d object%s: %d", size, size == 1 ? "" : "s", count);
+      }
+    } else {
+      ImGui::Text("BVH: none, the world is a list");
+    }
+
+    ImGui::Separator();
+
+    ImGui::Text("Memory: %s", FormatBytes(totalBytes()).c_str());
+    ImGui::BulletText("Geometry: %s", FormatBytes(geometryBytes).c_str());
+    ImGui::BulletText("BVH: %s", FormatBytes(bvhBytes).c_str());
+    ImGui::BulletText("Textures: %s", FormatBytes(textureBytes).c_str());
+    ImGui::BulletText("Environment: %s", FormatBytes(environmentBytes).c_str());
+    ImGui::BulletText("Framebuffers: %s", FormatBytes(frameBufferBytes).c_str());
+  }
+} // namespace rt
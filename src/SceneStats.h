@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace rt {
+  class FrameBuffer;
+  class Scene;
+
+  /**
+   * @brief Complexity and memory footprint of a loaded scene, to size machines before sending
+   * them renders.
+   *
+   * Memory is counted from the sizes of the objects and buffers themselves, allocator overhead
+   * isn't included. Textures are counted process-wide, images shared between scenes included.
+   */
+  struct SceneStats {
+    int                        objects = 0;
+    std::map<std::string, int> objectTypes; // Objects by the type they're saved with
+
+    // Zero if the world isn't a BVH
+    int                bvhNodes  = 0;
+    int                bvhLeaves = 0;
+    int                bvhDepth  = 0; // Nodes on the longest path from the root, both ends included
+    double             sahCost   = 0;
+    std::map<int, int> leafSizes; // Leaves by the number of objects they hold
+
+    std::size_t geometryBytes    = 0;
+    std::size_t bvhBytes         = 0;
+    std::size_t textureBytes     = 0; // Decoded images, their mips and the resident tiles of tiled ones
+    std::size_t environmentBytes = 0;
+    std::size_t frameBufferBytes = 0;
+
+    std::size_t totalBytes() const {
+      return geometryBytes + bvhBytes + textureBytes + environmentBytes + frameBufferBytes;
+    }
+
+    // `frameBuffer` can be null, for scenes that don't have one allocated yet
+    static SceneStats Collect(Scene const &scene, FrameBuffer const *frameBuffer);
+
+    void print(std::ostream &out) const;
+
+    void OnImgui() const;
+  };
+} // namespace rt
@@ -0,0 +1,109 @@
+#include "Topology.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+  // Parses sysfs cpu lists such as "0-15,32-47"
+  std::vector<int> parseCpuList(std::string const &list) {
+    std::vector<int>   cpus;
+    std::istringstream ss(list);
+    std::string        range;
+
+    while (std::getline(ss, range, ',')) {
+      if (range.empty())
+        continue;
+
+      auto dash  = range.find('-');
+      int  first = std::stoi(range.substr(0, dash));
+      int  last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+      for (int cpu = first; cpu <= last; cpu++)
+        cpus.push_back(cpu);
+    }
+
+    return cpus;
+  }
+
+  std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set))
+          cpus.push_back(cpu);
+      }
+    }
+#endif
+
+    if (cpus.empty()) {
+      for (int cpu = 0; cpu < (int)std::max(1u, std::thread::hardware_concurrency()); cpu++)
+        cpus.push_back(cpu);
+    }
+
+    return cpus;
+  }
+} // namespace
+
+namespace rt {
+  Topology const &Topology::get() {
+    static Topology topology;
+    return topology;
+  }
+
+  Topology::Topology() {
+    namespace fs = std::filesystem;
+
+    auto const allowed = allowedCpus();
+
+    std::error_code ec;
+    for (auto const &entry : fs::directory_iterator("/sys/devices/system/node", ec)) {
+      auto const name = entry.path().filename().string();
+      if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(name[4]))
+        continue;
+
+      std::ifstream cpuListFile(entry.path() / "cpulist");
+      std::string   cpuList;
+      std::getline(cpuListFile, cpuList);
+
+      NumaNode node{std::stoi(name.substr(4)), {}};
+      for (int cpu : parseCpuList(cpuList)) {
+        if (std::ranges::find(allowed, cpu) != allowed.end())
+          node.cpus.push_back(cpu);
+      }
+
+      // Memory-only nodes, or nodes we're not allowed to run on
+      if (!node.cpus.empty())
+        nodes.push_back(node);
+    }
+
+    std::ranges::sort(nodes, {}, &NumaNode::id);
+
+    if (nodes.empty())
+      nodes.push_back(NumaNode{0, allowed});
+  }
+
+  bool Topology::pinCurrentThread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+  }
+} // namespace rt
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+namespace rt {
+  struct NumaNode {
+    int              id;
+    std::vector<int> cpus; // Logical CPUs of this node the process is allowed to run on
+  };
+
+  /**
+   * @brief CPU and NUMA layout of the machine, read once from sysfs.
+   *
+   * Falls back to a single node containing every allowed CPU when sysfs has no NUMA
+   * information (or on non-Linux systems).
+   */
+  class Topology {
+  public:
+    static Topology const &get();
+
+    std::vector<NumaNode> const &getNodes() const { return nodes; }
+
+    // Pins the calling thread to a single logical CPU. Returns false if pinning isn't supported.
+    static bool pinCurrentThread(int cpu);
+
+  private:
+    Topology();
+
+    std::vector<NumaNode> nodes;
+  };
+} // namespace rt
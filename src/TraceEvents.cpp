@@ -0,0 +1,115 @@
+#include "TraceEvents.h"
+
+#include "Defs.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace rt {
+  namespace {
+    struct Event {
+      char const  *name;
+      std::int64_t start;    // Nanoseconds since the recording started
+      std::int64_t duration; // Nanoseconds
+    };
+
+    // Only its own thread appends to a log, the lock is there for `Write` reading it meanwhile
+    struct ThreadLog {
+      int                id;
+      std::string        name;
+      std::mutex         mutex;
+      std::vector<Event> events;
+    };
+
+    std::mutex                   logsMutex;
+    std::vector<sPtr<ThreadLog>> logs;
+
+    ThreadLog &LocalLog() {
+      thread_local sPtr<ThreadLog> log = [] {
+        auto created = std::make_shared<ThreadLog>();
+
+        std::lock_guard lock(logsMutex);
+        created->id = int(logs.size()) + 1;
+        logs.push_back(created);
+        return created;
+      }();
+
+      return *log;
+    }
+
+    // Chrome's timestamps are in microseconds, fractions included
+    double Microseconds(std::int64_t nanoseconds) { return nanoseconds / 1000.0; }
+  } // namespace
+
+  void TraceEvents::Start() {
+    epoch = Clock::now();
+    enabled.store(true, std::memory_order_release);
+  }
+
+  void TraceEvents::NameThread(std::string name) {
+    if (!Enabled())
+      return;
+
+    ThreadLog      &log = LocalLog();
+    std::lock_guard lock(log.mutex);
+    log.name = std::move(name);
+  }
+
+  void TraceEvents::Record(char const *name, Clock::time_point start, Clock::time_point end) {
+    using std::chrono::nanoseconds, std::chrono::duration_cast;
+
+    ThreadLog      &log = LocalLog();
+    std::lock_guard lock(log.mutex);
+    log.events.push_back(
+        {name, duration_cast<nanoseconds>(start - epoch).count(), duration_cast<nanoseconds>(end - start).count()});
+  }
+
+  bool TraceEvents::Write(std::string const &path) {
+    std::ofstream file(path);
+    if (!file) {
+      std::cerr << "Failed to write trace " << path << '\n';
+      return false;
+    }
+
+    std::vector<sPtr<ThreadLog>> threads;
+    {
+      std::lock_guard lock(logsMutex);
+      threads = logs;
+    }
+
+    // One event per line, so large traces stay readable and are written without building them in memory
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+
+    auto const writeEvent = [&](json const &event) {
+      file << (first ? "" : ",\n") << event.dump();
+      first = false;
+    };
+
+    for (auto const &thread : threads) {
+      std::lock_guard lock(thread->mutex);
+
+      if (!thread->name.empty())
+        writeEvent({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", thread->id},
+                    {"args", {{"name", thread->name}}}});
+
+      for (auto const &event : thread->events) {
+        writeEvent({{"name", event.name}, {"ph", "X"}, {"pid", 1}, {"tid", thread->id},
+                    {"ts", Microseconds(event.start)}, {"dur", Microseconds(event.duration)}});
+      }
+    }
+
+    file << "\n]}\n";
+
+    if (!file) {
+      std::cerr << "Failed to write trace " << path << '\n';
+      return false;
+    }
+
+    std::cout << "Wrote trace " << path << '\n';
+    return true;
+  }
+} // namespace rt
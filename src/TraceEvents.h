@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace rt {
+  /**
+   * @brief Records timed spans of the render's phases on every thread and writes them in the
+   * Chrome Trace Event format, to be opened in Perfetto or chrome://tracing.
+   *
+   * Nothing is recorded until `Start()`. Each thread appends to its own log, so recording a span
+   * costs two clock reads and an uncontended lock; spans are meant for phases and tiles, not
+   * for anything done per ray.
+   */
+  class TraceEvents {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // Starts recording, timestamps are relative to this call
+    static void Start();
+
+    static bool Enabled() { return enabled.load(std::memory_order_acquire); }
+
+    // Shown as the calling thread's track name
+    static void NameThread(std::string name);
+
+    // `name` has to outlive the recording, spans are named by string literals
+    static void Record(char const *name, Clock::time_point start, Clock::time_point end);
+
+    // Writes everything recorded so far, returns false if `path` couldn't be written
+    static bool Write(std::string const &path);
+
+  private:
+    inline static std::atomic<bool> enabled = false;
+    inline static Clock::time_point epoch;
+  };
+
+  // Records the span from its construction to the end of its scope, if recording is enabled
+  class TraceScope {
+  public:
+    explicit TraceScope(char const *name, bool record = true)
+        : name(record && TraceEvents::Enabled() ? name : nullptr) {
+      if (this->name)
+        start = TraceEvents::Clock::now();
+    }
+
+    ~TraceScope() {
+      if (name)
+        TraceEvents::Record(name, start, TraceEvents::Clock::now());
+    }
+
+    TraceScope(TraceScope const &)            = delete;
+    TraceScope &operator=(TraceScope const &) = delete;
+
+  private:
+    char const                   *name;
+    TraceEvents::Clock::time_point start;
+  };
+} // namespace rt
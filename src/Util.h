@@ -1,16 +1,34 @@
 #pragma once
 #include "Constants.h"
 #include "data_structures/vec3.h"
+#include <cstdint>
 #include <random>
 #include <raylib.h>
 
 inline float DegressToRadians(float degress) { return degress * rt::constants::pi / 180; }
 
+inline std::mt19937 &RandomGenerator() {
+  static thread_local std::mt19937 generator;
+  return generator;
+}
+
+// Restarts the calling thread's random sequence. Render workers seed it per tile, so a tile
+// renders the same no matter which thread picks it up or when.
+inline void SeedRandom(std::uint32_t seed) { RandomGenerator().seed(seed); }
+
+// Mixes a base seed with a position into a well distributed seed (splitmix64 finalizer)
+inline std::uint32_t HashSeed(std::uint32_t seed, int x, int y) {
+  std::uint64_t z = std::uint64_t(seed) * 0x9e3779b97f4a7c15ull + std::uint64_t(std::uint32_t(x)) * 0xc2b2ae3d27d4eb4full +
+                    std::uint64_t(std::uint32_t(y)) * 0x165667b19e3779f9ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return std::uint32_t(z ^ (z >> 31));
+}
+
 inline float RandomFloat() {
   // Returns a random float in [0,1)
   static thread_local std::uniform_real_distribution<float> distribution(0, 1);
-  static thread_local std::mt19937                          generator;
-  return distribution(generator);
+  return distribution(RandomGenerator());
 }
 
 inline float RandomFloat(float min, float max) {
@@ -5,18 +5,36 @@
 #include "Defs.h"
 #include "Ray.h"
 #include "Scene.h"
+#include "SceneStats.h"
 #include "data_structures/JobQueue.h"
 #include "editor/editor.h"
 #include "raytracer.h"
 #include "rt.h"
+#include "textures/TileCache.h"
 
 #include <raylib.h>
 #include <rlImGui.h>
 
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <memory>
 #include <string>
 
+void CliConfig::applyTo(RaytraceSettings &settings) const {
+  if (crop.size() == 4) {
+    settings.crop = true;
+    std::copy_n(crop.begin(), 4, settings.cropRegion);
+  }
+
+  if (traversalOrder)
+    settings.traversalOrder = *traversalOrder;
+
+  settings.renderMode      = renderMode;
+  settings.heatmapFullPath = heatmapFullPath;
+  settings.heatmapScale    = heatmapScale;
+}
+
 namespace rt {
   void App::setup() {
     editor->setNextState(rt);
@@ -38,11 +56,25 @@ namespace rt {
           return AsyncRenderData(config.imageWidth, config.imageHeight, config.editorWidth, config.editorHeight,
                                  config.numThreads);
         }()),
+        renderPool(config.numThreads, config.pinThreads),
         editorWidth(config.editorWidth), editorHeight(config.editorHeight),
         scene(config.pathToScene.empty() ? Scene::Earth(config.imageWidth, config.imageHeight)
                                          : Scene::Load(config.imageWidth, config.imageHeight, config.pathToScene)),
         editor(std::make_shared<Editor>(this, config, scene)), rt(std::make_shared<Raytracer>(this, ard)),
-        currentState(editor) {
+        currentState(editor), outputFormat(config.outputFormat), outputPath(config.outputPath),
+        checkpointPath(config.checkpointPath), checkpointInterval(config.checkpointInterval),
+        resumePath(config.resumePath) {
+    TileCache::Get().setBudget(std::size_t(config.textureBudgetMb) << 20);
+
+    // The pool decides how many nodes its workers are spread over, split the tiles the same way
+    ard.changeNumThreads(numThreads, renderPool.numNodes());
+    ard.setAovs(config.writeAovs);
+
+    config.applyTo(scene.settings);
+
+    if (config.printStats)
+      SceneStats::Collect(scene, &ard.frameBuffer).print(std::cout);
+
     setup();
   }
 
@@ -1,17 +1,48 @@
 #pragma once
 #include "AsyncRenderData.h"
+#include "RenderPool.h"
 #include "Scene.h"
+#include "output/ImageOutput.h"
+#include "output/ImageWriter.h"
 
+#include <optional>
 #include <string>
+#include <vector>
 
 struct CliConfig
 {
-  int         imageWidth  = -1;
-  int         imageHeight = -1;
-  int         editorWidth = 1280;
-  int         editorHeight = 720;
-  int         numThreads  = 6;
+  int         imageWidth      = -1;
+  int         imageHeight     = -1;
+  int         editorWidth     = 1280;
+  int         editorHeight    = 720;
+  int         numThreads      = 6;
+  bool        pinThreads      = false;
+  int         textureBudgetMb = 512;
   std::string pathToScene;
+
+  rt::OutputFormat outputFormat = rt::OutputFormat::bmp;
+  bool             writeAovs    = false;
+  std::string      outputPath; // Timestamped file in screenshots/ if empty
+
+  bool        headless           = false;
+  bool        streamOutput       = false; // Headless only, tiles go straight to a tiled exr
+  std::string checkpointPath;           // No checkpoints if empty
+  int         checkpointInterval = 300; // Seconds
+  std::string resumePath;
+
+  bool        printStats = false; // Prints the scene's complexity and memory footprint once it's loaded
+  std::string tracePath; // Chrome trace of the session's phases, not recorded if empty
+
+  std::vector<int> crop; // Left, top, right and bottom from the image's top left corner, empty to render it all
+
+  std::optional<rt::TraversalOrder> traversalOrder; // The scene's own if unset
+
+  rt::RenderMode renderMode      = rt::RenderMode::shaded;
+  bool           heatmapFullPath = false;
+  float          heatmapScale    = 64.0f;
+
+  // Copies the options that override the scene's render settings
+  void applyTo(RaytraceSettings &settings) const;
 };
 
 namespace rt {
@@ -23,6 +54,8 @@ namespace rt {
 
     Scene           scene;
     AsyncRenderData ard;
+    RenderPool      renderPool; // Declared after `scene` and `ard` so workers are stopped before they're destroyed
+    ImageWriter     imageWriter;
 
     sPtr<Editor>    editor;
     sPtr<Raytracer> rt;
@@ -35,7 +68,13 @@ namespace rt {
   public:
     int const editorWidth, editorHeight;
 
-    bool saveOnRender = true;
+    bool         saveOnRender = true;
+    OutputFormat outputFormat = OutputFormat::bmp;
+    std::string  outputPath;
+
+    std::string checkpointPath;
+    int         checkpointInterval;
+    std::string resumePath; // Cleared once the first render resumed from it
     void setup();
 
     App(CliConfig);
@@ -55,11 +94,14 @@ namespace rt {
 
     Scene           *getScene() { return &scene; }
     AsyncRenderData *getARD() { return &ard; }
+    RenderPool      *getRenderPool() { return &renderPool; }
+    ImageWriter     *getImageWriter() { return &imageWriter; }
     int              getNumThreads() const { return numThreads; }
 
     void changeNumThreads(int newNumThreads) {
       numThreads = newNumThreads;
-      ard.changeNumThreads(numThreads);
+      renderPool.resize(numThreads);
+      ard.changeNumThreads(numThreads, renderPool.numNodes());
     }
   };
 } // namespace rt
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+
+namespace rt {
+  /**
+   * @brief Flag render workers poll to stop early.
+   *
+   * Checked once per sample, so it has to stay a single relaxed load. Workers that see it set
+   * return as soon as their current sample is done.
+   */
+  class CancellationToken {
+  public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<bool> cancelled{false};
+  };
+} // namespace rt
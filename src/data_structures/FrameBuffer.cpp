@@ -0,0 +1,112 @@
+#include "FrameBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rt {
+  FrameBuffer::FrameBuffer(int width, int height, int tileSize, TraversalOrder tileOrder, bool withAovs,
+                           bool resident)
+      : width(width), height(height), tileSize(tileSize), tilesX((width + tileSize - 1) / tileSize),
+        tileOrder(tileOrder), withAovs(withAovs) {
+
+    if (resident) {
+      red.reset(new float[planeSize()]);
+      green.reset(new float[planeSize()]);
+      blue.reset(new float[planeSize()]);
+
+      if (withAovs)
+        aovs.reset(new float[aovPlanes * planeSize()]);
+    }
+
+    int const tilesY = (height + tileSize - 1) / tileSize;
+    tileAt.resize(tilesX * tilesY);
+
+    // Tiles next to each other in the order are also next to each other in memory
+    int offset = 0;
+    for (auto [tx, ty] : traversalOrder(tileOrder, tilesX, tilesY)) {
+      int const x0 = tx * tileSize, y0 = ty * tileSize;
+
+      Tile tile{x0, y0, std::min(x0 + tileSize, width), std::min(y0 + tileSize, height), offset};
+      tileAt[ty * tilesX + tx] = tiles.size();
+      tiles.push_back(tile);
+      offset += tile.pixelCount();
+    }
+  }
+
+  int FrameBuffer::index(int x, int y) const {
+    Tile const &tile = tiles[tileAt[(y / tileSize) * tilesX + x / tileSize]];
+    return tile.offset + (y - tile.y0) * tile.width() + (x - tile.x0);
+  }
+
+  void FrameBuffer::releasePlanes() {
+    red.reset();
+    green.reset();
+    blue.reset();
+    aovs.reset();
+  }
+
+  float *FrameBuffer::plane(int p) {
+    switch (p) {
+    case 0: return red.get();
+    case 1: return green.get();
+    case 2: return blue.get();
+    default: return aovs.get() + (p - 3) * planeSize();
+    }
+  }
+
+  void FrameBuffer::setAovs(int index, Aovs const &values) {
+    std::size_t const plane = planeSize();
+    float            *out   = aovs.get() + index;
+
+    out[0 * plane] = values.albedo.x;
+    out[1 * plane] = values.albedo.y;
+    out[2 * plane] = values.albedo.z;
+    out[3 * plane] = values.normal.x;
+    out[4 * plane] = values.normal.y;
+    out[5 * plane] = values.normal.z;
+    out[6 * plane] = values.depth;
+  }
+
+  FrameBuffer::Aovs FrameBuffer::getAovs(int index) const {
+    std::size_t const plane = planeSize();
+    float const      *in    = aovs.get() + index;
+
+    return {vec3(in[0 * plane], in[1 * plane], in[2 * plane]), vec3(in[3 * plane], in[4 * plane], in[5 * plane]),
+            in[6 * plane]};
+  }
+
+  void FrameBuffer::clear() {
+    std::fill_n(red.get(), planeSize(), 0.0f);
+    std::fill_n(green.get(), planeSize(), 0.0f);
+    std::fill_n(blue.get(), planeSize(), 0.0f);
+
+    if (aovs)
+      std::fill_n(aovs.get(), aovPlanes * planeSize(), 0.0f);
+  }
+
+  void FrameBuffer::clearTile(Tile const &tile) {
+    std::fill_n(red.get() + tile.offset, tile.pixelCount(), 0.0f);
+    std::fill_n(green.get() + tile.offset, tile.pixelCount(), 0.0f);
+    std::fill_n(blue.get() + tile.offset, tile.pixelCount(), 0.0f);
+
+    for (int p = 0; aovs && p < aovPlanes; p++)
+      std::fill_n(aovs.get() + p * planeSize() + tile.offset, tile.pixelCount(), 0.0f);
+  }
+
+  void FrameBuffer::toRGBA8(Color *out) const {
+    for (auto const &tile : tiles) {
+      for (int y = tile.y0; y < tile.y1; y++) {
+        for (int x = tile.x0; x < tile.x1; x++) {
+          vec3 color = get(tile.offset + (y - tile.y0) * tile.width() + (x - tile.x0));
+
+#ifdef GAMMA_CORRECTION
+          // Gamma correction
+          color = vec3(std::sqrt(color.x), std::sqrt(color.y), std::sqrt(color.z));
+#endif
+
+          out[std::size_t(y) * width + x] = color.toRaylibColor(255);
+        }
+      }
+    }
+  }
+} // namespace rt
@@ -0,0 +1,112 @@
+#pragma once
+#include "Tile.h"
+#include "TraversalOrder.h"
+#include "vec3.h"
+
+#include <raylib.h>
+
+#include <memory>
+#include <vector>
+
+namespace rt {
+  /**
+   * @brief Planar float RGB buffer the render workers write their results into.
+   *
+   * Pixels are stored tile by tile (row-major inside each tile), so a worker rendering a tile
+   * writes one contiguous range of each plane and only shares cache lines with other workers
+   * at the tile's ends.
+   *
+   * The planes are allocated without being initialized, so their pages are first touched (and
+   * placed on a NUMA node) by whichever worker renders into them rather than by the UI thread.
+   *
+   * Optionally holds AOV planes (albedo, normal and depth of the first hit) laid out the same way.
+   */
+  class FrameBuffer {
+  public:
+    // Arbitrary output values of the surface a camera ray hits first, averaged over the samples.
+    // All zero where nothing was hit.
+    struct Aovs {
+      vec3  albedo = vec3::Zero();
+      vec3  normal = vec3::Zero();
+      float depth  = 0.0f; // Distance from the camera
+    };
+
+    FrameBuffer() = default;
+    // Tiles are laid out (and listed by `getTiles`) in `tileOrder`. Without `resident` only the
+    // layout is built, as if `releasePlanes` was called right away.
+    FrameBuffer(int width, int height, int tileSize, TraversalOrder tileOrder = TraversalOrder::scanline,
+                bool withAovs = false, bool resident = true);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    TraversalOrder getTileOrder() const { return tileOrder; }
+
+    std::vector<Tile> const &getTiles() const { return tiles; }
+
+    // Index of the screen-space pixel (x, y) in the planes
+    int index(int x, int y) const;
+
+    // Position of `tile` in `getTiles()`
+    int tileIndex(Tile const &tile) const { return tileAt[(tile.y0 / tileSize) * tilesX + tile.x0 / tileSize]; }
+
+    // Color planes (red, green, blue) followed by the AOV planes if there are any.
+    // Each holds one float per pixel, in the same tiled layout.
+    int          planeCount() const { return PlaneCount(withAovs); }
+    static int   PlaneCount(bool withAovs) { return withAovs ? 3 + aovPlanes : 3; }
+    float       *plane(int p);
+    float const *plane(int p) const { return const_cast<FrameBuffer *>(this)->plane(p); }
+
+    void set(int index, const vec3 &color) {
+      red[index]   = color.x;
+      green[index] = color.y;
+      blue[index]  = color.z;
+    }
+
+    vec3 get(int index) const { return vec3(red[index], green[index], blue[index]); }
+
+    bool hasAovs() const { return withAovs; }
+
+    // Frees the planes but keeps the tile layout, for renders that stream tiles out instead of
+    // keeping them. Nothing but the layout may be used afterwards.
+    void releasePlanes();
+    bool isResident() const { return red != nullptr; }
+
+    // Memory held by the planes, none once they're released
+    std::size_t residentBytes() const {
+      return isResident() ? planeSize() * planeCount() * sizeof(float) : 0;
+    }
+
+    // Only valid if `hasAovs()`
+    void setAovs(int index, Aovs const &values);
+    Aovs getAovs(int index) const;
+
+    // Zeroes all planes without reallocating them
+    void clear();
+
+    // Zeroes the pixels (and AOVs) of a single tile, meant to be called by the worker about to render it
+    void clearTile(Tile const &tile);
+
+    // Writes the buffer as row-major RGBA8, starting with the bottom row (y = 0)
+    void toRGBA8(Color *out) const;
+
+  private:
+    // Floats in a plane. Kept in std::size_t, several planes of a poster sized render overflow int.
+    std::size_t planeSize() const { return std::size_t(width) * height; }
+
+    int width = 0, height = 0;
+    int tileSize = 0, tilesX = 0;
+
+    TraversalOrder tileOrder = TraversalOrder::scanline;
+    bool           withAovs  = false;
+
+    std::vector<Tile> tiles;
+    std::vector<int>  tileAt; // Index into `tiles` of each cell of the row-major tile grid
+
+    std::unique_ptr<float[]> red, green, blue;
+
+    // 7 planes one after the other: albedo RGB, normal XYZ, depth. Null without AOVs.
+    std::unique_ptr<float[]> aovs;
+    static constexpr int     aovPlanes = 7;
+  };
+} // namespace rt
@@ -1,23 +1,22 @@
 #pragma once
 
-#include "AsyncRenderData.h"
+#include "../TraceEvents.h"
+
 #include <algorithm>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <utility>
 #include <vector>
 
 namespace rt {
 
-  class AsyncRenderData;
-
   template <typename JobData> class JobQueue {
   private:
     std::vector<JobData> jobs;
-    int             currentChunkStart;
-    std::mutex      queueMutex;
-
-    std::condition_variable threadBarrier;
+    int                  currentChunkStart = 0;
+    std::mutex           queueMutex;
+    std::atomic<long>    waitNanoseconds = 0;
 
     const int chunkSize;
 
@@ -31,26 +30,28 @@ namespace rt {
     // Used to add jobs by the main thread.
     void addJobNoLock(JobData newJobData) { jobs.push_back(newJobData); }
 
-    std::pair<typename std::vector<JobData>::iterator, typename std::vector<JobData>::iterator>
-    getChunk(AsyncRenderData &ard, int threadIndex) {
+    // Returns the next chunk of jobs, or an empty range once all jobs are consumed.
+    std::pair<typename std::vector<JobData>::iterator, typename std::vector<JobData>::iterator> getChunk() {
 
       // Unlocks automatically on scope end
-      std::unique_lock<std::mutex> lk{queueMutex};
-
-      // All jobs consumed, wait untill the main thread refreshes jobs and notifies threads.
-      // Or main thread wants to stop threads
-      if (currentChunkStart > jobs.size() - 1) {
-        ard.finishedThreads[threadIndex] = true;
-        threadBarrier.wait(lk);
+      std::unique_lock<std::mutex> lk{queueMutex, std::try_to_lock};
+      if (!lk.owns_lock()) {
+        // Another worker is claiming tiles, only this case is timed so uncontended calls stay cheap
+        TraceScope const trace("Wait for job queue");
+        auto const       waitStart = std::chrono::steady_clock::now();
+
+        lk.lock();
+        waitNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count(),
+            std::memory_order_relaxed);
       }
 
-      auto start  = jobs.begin() + currentChunkStart;
-      auto offset = std::min((currentChunkStart + chunkSize), (int)jobs.size() - 1);
-      auto end    = jobs.begin() + offset;
+      auto startOffset = std::min(currentChunkStart, (int)jobs.size());
+      auto endOffset   = std::min(startOffset + chunkSize, (int)jobs.size());
 
-      currentChunkStart = getCurrentChunkStart() + chunkSize;
+      currentChunkStart = endOffset;
 
-      return std::make_pair(start, end);
+      return std::make_pair(jobs.begin() + startOffset, jobs.begin() + endOffset);
     }
 
     std::vector<JobData> &getJobsVector() { return jobs; }
@@ -59,11 +60,10 @@ namespace rt {
 
     int getChunkSize() const { return chunkSize; }
 
-    void awakeAllWorkers() {
-      currentChunkStart = 0;
-      threadBarrier.notify_all();
-    }
-
     void setCurrentChunkStart(int ccs) { currentChunkStart = ccs; }
+
+    // Time workers spent blocked on another worker's `getChunk`, summed over all of them
+    long getWaitNanoseconds() const { return waitNanoseconds.load(std::memory_order_relaxed); }
+    void resetWaitTime() { waitNanoseconds.store(0, std::memory_order_relaxed); }
   };
 } // namespace rt
@@ -0,0 +1,69 @@
+#pragma once
+
+namespace rt {
+  // Leaf shapes told apart by the traversal counters, containers (BVH nodes, lists, boxes) and
+  // media are `other`
+  enum class PrimitiveType { other, sphere, movingSphere, triangle, rect, plane, primitiveTypesCount };
+
+  inline static const char *primitiveTypeLabels[] = {"Other", "Sphere", "Moving sphere", "Triangle", "Rect", "Plane"};
+
+  /**
+   * @brief What a render worker traced and how much traversal work it took.
+   *
+   * Each thread counts into its own `Local()` copy with plain increments, so counting costs
+   * about as much as the add itself. Workers publish their copy to their (cache line padded)
+   * `ThreadStats` once per tile.
+   */
+  struct RayCounters {
+    static constexpr int primitiveTypes = static_cast<int>(PrimitiveType::primitiveTypesCount);
+
+    long primaryRays   = 0; // Camera rays, one per sample
+    long secondaryRays = 0; // Bounces
+    long shadowRays    = 0; // Environment light samples
+    long nodesVisited  = 0; // BVH nodes whose box was tested
+
+    long primitiveTests[primitiveTypes] = {};
+    long primitiveHits[primitiveTypes]  = {};
+
+    static RayCounters &Local() {
+      thread_local RayCounters counters;
+      return counters;
+    }
+
+    void countTest(PrimitiveType type, bool hit) {
+      primitiveTests[static_cast<int>(type)]++;
+      primitiveHits[static_cast<int>(type)] += hit;
+    }
+
+    long rays() const { return primaryRays + secondaryRays + shadowRays; }
+
+    // Intersection tests against leaf shapes, `other` excluded
+    long leafTests() const {
+      long tests = 0;
+      for (int t = 1; t < primitiveTypes; t++) {
+        tests += primitiveTests[t];
+      }
+
+      return tests;
+    }
+
+    // Segments per camera path, 1 if no ray ever bounced
+    double averagePathDepth() const {
+      return primaryRays > 0 ? double(primaryRays + secondaryRays) / primaryRays : 0.0;
+    }
+
+    RayCounters &operator+=(RayCounters const &other) {
+      primaryRays += other.primaryRays;
+      secondaryRays += other.secondaryRays;
+      shadowRays += other.shadowRays;
+      nodesVisited += other.nodesVisited;
+
+      for (int t = 0; t < primitiveTypes; t++) {
+        primitiveTests[t] += other.primitiveTests[t];
+        primitiveHits[t] += other.primitiveHits[t];
+      }
+
+      return *this;
+    }
+  };
+} // namespace rt
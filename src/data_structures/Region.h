@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Tile.h"
+
+#include <algorithm>
+
+namespace rt {
+  /**
+   * @brief A rectangle of pixels in framebuffer space (y going up), used to render only part of the image
+   */
+  struct Region {
+    int x0 = 0, y0 = 0; // Lower corner (inclusive)
+    int x1 = 0, y1 = 0; // Upper corner (exclusive)
+
+    // From image coordinates, where y goes down from the top row
+    static Region FromImage(int left, int top, int right, int bottom, int imageHeight) {
+      return {left, imageHeight - bottom, right, imageHeight - top};
+    }
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    bool contains(int x, int y) const { return x >= x0 && x < x1 && y >= y0 && y < y1; }
+
+    bool intersects(Tile const &tile) const {
+      return !empty() && tile.x0 < x1 && x0 < tile.x1 && tile.y0 < y1 && y0 < tile.y1;
+    }
+
+    Region united(Region const &other) const {
+      if (empty())
+        return other;
+      if (other.empty())
+        return *this;
+
+      return {std::min(x0, other.x0), std::min(y0, other.y0), std::max(x1, other.x1), std::max(y1, other.y1)};
+    }
+
+    Region intersected(Region const &other) const {
+      return {std::max(x0, other.x0), std::max(y0, other.y0), std::min(x1, other.x1), std::min(y1, other.y1)};
+    }
+
+    Region clamped(int width, int height) const { return intersected({0, 0, width, height}); }
+  };
+} // namespace rt
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace rt {
+  // What pixels show: the shaded image, or the traversal cost of their rays as a heatmap
+  enum class RenderMode { shaded, nodeVisits, primitiveTests, renderModesCount };
+
+  inline static const char *renderModeLabels[] = {"Shaded", "BVH node visits", "Primitive tests"};
+
+  // Used on the command line and in checkpoint hashes
+  inline static const char *renderModeNames[] = {"shaded", "nodes", "tests"};
+} // namespace rt
@@ -0,0 +1,70 @@
+#pragma once
+#include "../Constants.h"
+#include "RayCounters.h"
+
+#include <atomic>
+
+namespace rt {
+  /**
+   * @brief Progress information a render worker publishes for the UI.
+   *
+   * Each worker only ever writes its own entry, and entries are padded to a cache line so
+   * that workers updating their stats don't invalidate each other's lines.
+   */
+  struct alignas(rt::constants::cacheLineSize) ThreadStats {
+    std::atomic<int>  progress{0};       // Progress through the current tile in percent
+    std::atomic<long> time{0};           // Time spent rendering in ms
+    std::atomic<bool> finished{false};   // Set once the worker found no more jobs
+    std::atomic<int>  tiles{0};          // Tiles rendered by this worker
+    std::atomic<int>  stolenTiles{0};    // Tiles taken from another NUMA node's queue
+
+    // Last-level cache counters over the whole render, published when the worker finishes
+    std::atomic<bool> cacheCountersAvailable{false};
+    std::atomic<long> cacheReferences{0};
+    std::atomic<long> cacheMisses{0};
+
+    // The worker's `RayCounters` as of its last finished tile
+    std::atomic<long> primaryRays{0}, secondaryRays{0}, shadowRays{0}, nodesVisited{0};
+    std::atomic<long> primitiveTests[RayCounters::primitiveTypes]{};
+    std::atomic<long> primitiveHits[RayCounters::primitiveTypes]{};
+
+    void publish(RayCounters const &counters) {
+      primaryRays.store(counters.primaryRays, std::memory_order_relaxed);
+      secondaryRays.store(counters.secondaryRays, std::memory_order_relaxed);
+      shadowRays.store(counters.shadowRays, std::memory_order_relaxed);
+      nodesVisited.store(counters.nodesVisited, std::memory_order_relaxed);
+
+      for (int t = 0; t < RayCounters::primitiveTypes; t++) {
+        primitiveTests[t].store(counters.primitiveTests[t], std::memory_order_relaxed);
+        primitiveHits[t].store(counters.primitiveHits[t], std::memory_order_relaxed);
+      }
+    }
+
+    RayCounters counters() const {
+      RayCounters counters;
+      counters.primaryRays   = primaryRays.load(std::memory_order_relaxed);
+      counters.secondaryRays = secondaryRays.load(std::memory_order_relaxed);
+      counters.shadowRays    = shadowRays.load(std::memory_order_relaxed);
+      counters.nodesVisited  = nodesVisited.load(std::memory_order_relaxed);
+
+      for (int t = 0; t < RayCounters::primitiveTypes; t++) {
+        counters.primitiveTests[t] = primitiveTests[t].load(std::memory_order_relaxed);
+        counters.primitiveHits[t]  = primitiveHits[t].load(std::memory_order_relaxed);
+      }
+
+      return counters;
+    }
+
+    void reset() {
+      progress.store(0, std::memory_order_relaxed);
+      time.store(0, std::memory_order_relaxed);
+      finished.store(false, std::memory_order_relaxed);
+      tiles.store(0, std::memory_order_relaxed);
+      stolenTiles.store(0, std::memory_order_relaxed);
+      publish(RayCounters());
+      cacheCountersAvailable.store(false, std::memory_order_relaxed);
+      cacheReferences.store(0, std::memory_order_relaxed);
+      cacheMisses.store(0, std::memory_order_relaxed);
+    }
+  };
+} // namespace rt
@@ -0,0 +1,16 @@
+#pragma once
+
+namespace rt {
+  /**
+   * @brief A rectangular block of pixels rendered as a single job
+   */
+  struct Tile {
+    int x0, y0; // Lower corner of the tile in screen-space (inclusive)
+    int x1, y1; // Upper corner of the tile in screen-space (exclusive)
+    int offset; // Index of the tile's first pixel in the framebuffer planes
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+    int pixelCount() const { return width() * height(); }
+  };
+} // namespace rt
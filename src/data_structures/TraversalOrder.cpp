@@ -0,0 +1,72 @@
+#include "TraversalOrder.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+  // Every other bit of `d`, starting with the lowest one
+  int compactBits(unsigned d) {
+    d &= 0x55555555u;
+    d = (d | (d >> 1)) & 0x33333333u;
+    d = (d | (d >> 2)) & 0x0F0F0F0Fu;
+    d = (d | (d >> 4)) & 0x00FF00FFu;
+    d = (d | (d >> 8)) & 0x0000FFFFu;
+    return d;
+  }
+
+  std::pair<int, int> mortonToXY(unsigned d) { return {compactBits(d), compactBits(d >> 1)}; }
+
+  // Position of the `d`th cell along the Hilbert curve filling a `side` x `side` square
+  std::pair<int, int> hilbertToXY(int side, unsigned d) {
+    int x = 0, y = 0;
+
+    for (int s = 1; s < side; s *= 2) {
+      int rx = 1 & (d / 2);
+      int ry = 1 & (d ^ rx);
+
+      // Rotate the quadrant
+      if (ry == 0) {
+        if (rx == 1) {
+          x = s - 1 - x;
+          y = s - 1 - y;
+        }
+        std::swap(x, y);
+      }
+
+      x += s * rx;
+      y += s * ry;
+      d /= 4;
+    }
+
+    return {x, y};
+  }
+} // namespace
+
+namespace rt {
+  std::vector<std::pair<int, int>> traversalOrder(TraversalOrder order, int width, int height) {
+    std::vector<std::pair<int, int>> cells;
+    cells.reserve(width * height);
+
+    if (order == TraversalOrder::scanline) {
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          cells.emplace_back(x, y);
+        }
+      }
+
+      return cells;
+    }
+
+    int const      side  = std::bit_ceil((unsigned)std::max({width, height, 1}));
+    unsigned const count = side * side;
+
+    for (unsigned d = 0; d < count; d++) {
+      auto [x, y] = order == TraversalOrder::morton ? mortonToXY(d) : hilbertToXY(side, d);
+
+      if (x < width && y < height)
+        cells.emplace_back(x, y);
+    }
+
+    return cells;
+  }
+} // namespace rt
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace rt {
+  // Order tiles are handed out in, and pixels are rendered in inside a tile
+  enum class TraversalOrder { scanline, morton, hilbert, traversalOrdersCount };
+
+  inline static const char *traversalOrderLabels[] = {"Scanline", "Morton", "Hilbert"};
+
+  // Used on the command line
+  inline static const char *traversalOrderNames[] = {"scanline", "morton", "hilbert"};
+
+  // Visiting order of the cells of a `width` x `height` grid as (x, y) pairs.
+  // Grids that aren't a power of two square follow the curve of the enclosing one, skipping cells
+  // outside the grid, so neighbouring cells stay close in the order.
+  std::vector<std::pair<int, int>> traversalOrder(TraversalOrder order, int width, int height);
+} // namespace rt
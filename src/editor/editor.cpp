@@ -69,6 +69,11 @@ namespace rt {
        "ALT+O",
        {KEY_LEFT_ALT, KEY_RIGHT_ALT},
        KEY_O},
+      {"Scene statistics",
+       [](auto &viewState) { viewState.viewMenu.sceneStats = !viewState.viewMenu.sceneStats; },
+       "ALT+I",
+       {KEY_LEFT_ALT, KEY_RIGHT_ALT},
+       KEY_I},
       {"Hide all",
        [](auto &viewState) { viewState.viewMenu = {false, false, false}; },
        "ALT+H",
@@ -90,10 +95,8 @@ namespace rt {
     {
       DrawGrid(10, 10);
 
-      if (!getScene()->skysphereTexture.empty()) {
-        getScene()->skysphere->transformation.setTranslation(camera.getLookFrom());
-        getScene()->drawSkysphere();
-      }
+      if (getScene()->environment)
+        getScene()->drawEnvironment(camera.getLookFrom());
 
       auto rasterizables = getScene()->worldRoot->getChildrenAsList();
 
@@ -162,6 +165,9 @@ namespace rt {
     if (viewState.viewMenu.cameraSettings)
       camera.RenderImgui();
 
+    if (viewState.viewMenu.sceneStats)
+      SceneStatsImgui();
+
     SelectedObjectImGui();
   }
 
@@ -458,8 +464,8 @@ namespace rt {
     scene->imageWidth  = camera.imageWidth();
     scene->imageHeight = camera.imageHeight();
 
-    *app->getARD() = AsyncRenderData(camera.imageWidth(), camera.imageHeight(), app->editorWidth, app->editorHeight,
-                                     app->getNumThreads());
+    // Keeps the existing buffers if the resolution didn't change, they're reset when the render starts
+    app->getARD()->resize(camera.imageWidth(), camera.imageHeight());
   }
 
   void Editor::RenderViewport() {
@@ -483,6 +489,16 @@ namespace rt {
     ImGui::End();
   }
 
+  void Editor::SceneStatsImgui() {
+    if (ImGui::Begin("Scene statistics", &viewState.viewMenu.sceneStats)) {
+      if (ImGui::Button("Refresh", {-1, 0}) || !sceneStats)
+        sceneStats = SceneStats::Collect(*getScene(), &app->getARD()->frameBuffer);
+
+      sceneStats->OnImgui();
+    }
+    ImGui::End();
+  }
+
   void Editor::ObjectListImgui() {
     auto objects = getScene()->worldRoot->getChildrenAsList();
     for (auto &&o : objects) {
@@ -573,5 +589,6 @@ namespace rt {
   void Editor::changeScene(Scene *scene) {
     camera.updateFromRtCamera(scene->cam);
     selectedObject = nullptr;
+    sceneStats.reset();
   }
 } // namespace rt
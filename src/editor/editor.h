@@ -3,6 +3,7 @@
 #include "../Defs.h"
 #include "../IState.h"
 #include "../Scene.h"
+#include "../SceneStats.h"
 #include "../materials/Material.h"
 #include "app.h"
 #include "camera.h"
@@ -34,6 +35,7 @@ namespace rt {
       struct ViewMenu {
         bool shouldOpen{false};
         bool raytracingSettings{true}, cameraSettings{true}, objectList{true};
+        bool sceneStats{false};
       };
 
       struct BuiltInMenu {
@@ -95,6 +97,9 @@ namespace rt {
 
     void ObjectListImgui();
 
+    // Complexity and memory footprint of the scene, collected when the panel is opened or refreshed
+    void SceneStatsImgui();
+
     static std::optional<sPtr<Material>> MaterialChanger();
 
     void TopMenuImgui();
@@ -128,5 +133,7 @@ namespace rt {
 
     ViewState viewState;
 
+    std::optional<SceneStats> sceneStats; // Collected again when empty
+
   }; // namespace Editor
 } // namespace rt
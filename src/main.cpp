@@ -1,5 +1,8 @@
+#include "Headless.h"
 #include "Scene.h"
+#include "TraceEvents.h"
 #include "app.h"
+#include "textures/TiledImage.h"
 
 #include <argumentum/argparse.h>
 
@@ -7,6 +10,7 @@
 #include <ostream>
 #include <string>
 #include <tuple>
+#include <vector>
 /*
  TODO:
     Update CLI flags for image and editor width and height with new flags that accept "widthxheight"
@@ -64,11 +68,30 @@
 
 using namespace argumentum;
 
+bool Pretile(std::string const &input, std::string const &output) {
+  Image image = LoadImage(input.c_str());
+  if (image.data == nullptr)
+    return false;
+
+  ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+  bool written = rt::TiledImage::Write(image, output);
+  UnloadImage(image);
+
+  if (written)
+    std::cout << "Wrote tiled image " << output << '\n';
+
+  return written;
+}
+
 CliConfig setupArguments(int argc, char **argv) {
   const int imageWidthDefault = 900;
   const int numThreadsDefault = 6;
 
-  CliConfig config;
+  CliConfig                config;
+  std::vector<std::string> pretile;
+  std::string              outputFormat;
+  std::string              renderMode;
+  std::string              traversalOrder;
 
   argument_parser parser = argument_parser{};
   auto            params = parser.params();
@@ -122,9 +145,151 @@ CliConfig setupArguments(int argc, char **argv) {
         }
       });
 
+  parser.add_argument(config.textureBudgetMb, "--texture-budget")
+      .maxargs(1)
+      .metavar("UNSIGNED INT")
+      .absent(config.textureBudgetMb)
+      .help("Memory budget in MiB for texture tiles streamed from pre-tiled (.rtt) images");
+
+  parser.add_argument(pretile, "--pretile")
+      .nargs(2)
+      .metavar("INPUT OUTPUT")
+      .help("Convert an image into a pre-tiled, mip-mapped .rtt texture that's streamed from disk, then exit");
+
+  parser.add_argument(config.pinThreads, "--pin-threads")
+      .nargs(0)
+      .absent(false)
+      .help("Pin each render thread to a CPU, spreading threads over NUMA nodes and splitting the image between them");
+
+  parser.add_argument(outputFormat, "--output-format")
+      .maxargs(1)
+      .metavar("bmp|pfm|exr")
+      .absent("bmp")
+      .help("Format renders are saved in, pfm and exr keep the linear float values");
+
+  parser.add_argument(config.writeAovs, "--aovs")
+      .nargs(0)
+      .absent(false)
+      .help("Also save the albedo, normal and depth of the first hit (as extra exr channels or pfm files)");
+
+  parser.add_argument(config.outputPath, "--output")
+      .maxargs(1)
+      .metavar("STRING PATH")
+      .absent("")
+      .help("Path renders are saved to, a timestamped file in screenshots/ by default");
+
+  parser.add_argument(config.headless, "--headless")
+      .nargs(0)
+      .absent(false)
+      .help("Render the scene without opening a window, save it and exit");
+
+  parser.add_argument(config.streamOutput, "--stream")
+      .nargs(0)
+      .absent(false)
+      .help("With --headless, write tiles to a tiled exr as they finish instead of keeping the frame in memory");
+
+  parser.add_argument(config.checkpointPath, "--checkpoint")
+      .maxargs(1)
+      .metavar("STRING PATH")
+      .absent("")
+      .help("Periodically save the finished tiles of the render to this file");
+
+  parser.add_argument(config.checkpointInterval, "--checkpoint-interval")
+      .maxargs(1)
+      .metavar("UNSIGNED INT")
+      .absent(config.checkpointInterval)
+      .help("Seconds between checkpoints");
+
+  parser.add_argument(config.resumePath, "--resume")
+      .maxargs(1)
+      .metavar("STRING PATH")
+      .absent("")
+      .help("Continue the render saved in this checkpoint, the scene and settings must match");
+
+  parser.add_argument(config.crop, "--crop")
+      .nargs(4)
+      .metavar("LEFT TOP RIGHT BOTTOM")
+      .help("Only render this rectangle of the image, in pixels from its top left corner");
+
+  parser.add_argument(config.printStats, "--stats")
+      .nargs(0)
+      .absent(false)
+      .help("Print the scene's object and BVH statistics and its memory footprint once it's loaded");
+
+  parser.add_argument(config.tracePath, "--trace")
+      .maxargs(1)
+      .metavar("FILE.json")
+      .absent("")
+      .help("Record the render's phases on every thread and write them as a Chrome trace (open it in Perfetto)");
+
+  parser.add_argument(traversalOrder, "--traversal-order")
+      .maxargs(1)
+      .metavar("scanline|morton|hilbert")
+      .absent("")
+      .help("Order tiles and the pixels inside them are rendered in, the scene's setting if absent");
+
+  parser.add_argument(renderMode, "--render-mode")
+      .maxargs(1)
+      .metavar("shaded|nodes|tests")
+      .absent("shaded")
+      .help("Render a heatmap of the BVH nodes visited or the shapes tested per pixel instead of the shaded image");
+
+  parser.add_argument(config.heatmapFullPath, "--heatmap-full-path")
+      .nargs(0)
+      .absent(false)
+      .help("Count the traversal work of whole paths in heatmaps, not just camera rays");
+
+  parser.add_argument(config.heatmapScale, "--heatmap-scale")
+      .maxargs(1)
+      .metavar("FLOAT")
+      .absent(config.heatmapScale)
+      .help("Nodes or tests per sample shown at the top of the heatmap's color ramp");
+
   if (!parser.parse_args(argc, argv, 1))
     std::exit(1);
 
+  if (!pretile.empty())
+    std::exit(Pretile(pretile[0], pretile[1]) ? 0 : 1);
+
+
+  config.outputFormat = rt::OutputFormat::outputFormatsCount;
+  for (int i = 0; i < static_cast<int>(rt::OutputFormat::outputFormatsCount); i++) {
+    if (outputFormat == rt::outputFormatLabels[i])
+      config.outputFormat = static_cast<rt::OutputFormat>(i);
+  }
+
+  if (config.outputFormat == rt::OutputFormat::outputFormatsCount) {
+    std::cout << "WARNING: Unknown output format (" << outputFormat << "), saving as bmp" << std::endl;
+    config.outputFormat = rt::OutputFormat::bmp;
+  }
+
+  config.renderMode = rt::RenderMode::renderModesCount;
+  for (int i = 0; i < static_cast<int>(rt::RenderMode::renderModesCount); i++) {
+    if (renderMode == rt::renderModeNames[i])
+      config.renderMode = static_cast<rt::RenderMode>(i);
+  }
+
+  if (config.renderMode == rt::RenderMode::renderModesCount) {
+    std::cout << "WARNING: Unknown render mode (" << renderMode << "), rendering shaded" << std::endl;
+    config.renderMode = rt::RenderMode::shaded;
+  }
+
+  // Same minimum as the editor's control: zero would divide by zero, and negative scales put every pixel at the
+  // bottom of the ramp
+  if (!(config.heatmapScale >= 1.0f)) {
+    std::cout << "WARNING: Heatmap scale (" << config.heatmapScale << ") is below 1, using 1" << std::endl;
+    config.heatmapScale = 1.0f;
+  }
+
+  if (!traversalOrder.empty()) {
+    for (int i = 0; i < static_cast<int>(rt::TraversalOrder::traversalOrdersCount); i++) {
+      if (traversalOrder == rt::traversalOrderNames[i])
+        config.traversalOrder = static_cast<rt::TraversalOrder>(i);
+    }
+
+    if (!config.traversalOrder)
+      std::cout << "WARNING: Unknown traversal order (" << traversalOrder << "), using the scene's" << std::endl;
+  }
 
   // Image width is set but image height is not
   if (config.imageHeight == -1) {
@@ -138,8 +303,23 @@ int main(int argc, char **argv) {
 
   auto cliConfig = setupArguments(argc, argv);
 
-  rt::App app(cliConfig);
-  app.run();
+  if (!cliConfig.tracePath.empty()) {
+    rt::TraceEvents::Start();
+    rt::TraceEvents::NameThread("Main");
+  }
+
+  int status = 0;
+
+  if (cliConfig.headless) {
+    status = rt::RenderHeadless(cliConfig);
+  } else {
+    rt::App app(cliConfig);
+    app.run();
+  }
+
+  // Once the app is gone, so the image writer's last files are in the trace
+  if (!cliConfig.tracePath.empty())
+    rt::TraceEvents::Write(cliConfig.tracePath);
 
-  return 0;
+  return status;
 }
@@ -33,7 +33,7 @@ namespace rt {
      */
     virtual bool scatter(const Ray &rIn, HitRecord &rec, vec3 &attenuation, Ray &scattered) const override {
 
-      attenuation  = albedo->Value(rec.u, rec.v, rec.p);
+      attenuation  = albedo->Sample(rec.u, rec.v, rec.p, rec.footprint);
       float refIdx = rec.front_face ? (1 / refractionIndex) : refractionIndex;
 
       vec3  unitDir  = rIn.direction.Normalize();
@@ -46,9 +46,12 @@ namespace rt {
      * @param u Horizontal texture coordinate
      * @param v Vertical texture coordinate
      * @param p Hit point in world space
+     * @param footprint Width of the incoming ray's cone in texture space
      * @return vec3 Color of light that this material emits
      */
-    virtual vec3 emitted(float u, float v, const vec3 &p) const override { return emssiveTex->Value(u, v, p); }
+    virtual vec3 emitted(float u, float v, const vec3 &p, float footprint) const override {
+      return emssiveTex->Sample(u, v, p, footprint);
+    }
 
     json toJson() const override { return json{{"type", "diffuse_light"}, {"texture", emssiveTex->toJson()}}; }
 
@@ -1,7 +1,9 @@
+#include "../Constants.h"
 #include "../Defs.h"
 #include "../materials/Material.h"
 #include "../textures/SolidColor.h"
 #include "../textures/Texture.h"
+#include <algorithm>
 #include <memory>
 #include <raylib.h>
 namespace rt {
@@ -13,10 +15,18 @@ namespace rt {
 
     virtual bool scatter(const Ray &r_in, HitRecord &rec, vec3 &attenuation, Ray &scattered) const override {
       scattered   = Ray(rec.p, vec3::RandomInUnitSphere(), r_in.time);
-      attenuation = albedo->Value(rec.u, rec.v, rec.p);
+      attenuation = albedo->Sample(rec.u, rec.v, rec.p, rec.footprint);
       return true;
     }
 
+    virtual float scatterSpread(float incomingSpread) const override {
+      return std::max(incomingSpread, rt::constants::diffuseConeSpread);
+    }
+
+    virtual float scatterPdf(const HitRecord &rec, const vec3 &direction) const override {
+      return 1.0f / (4 * rt::constants::pi);
+    }
+
     json toJson() const override { return {"type", "unimplemented - isotropic"}; }
 
     virtual void OnImgui() override { albedo->OnImgui(); }
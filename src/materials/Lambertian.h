@@ -1,9 +1,12 @@
 #pragma once
+#include "../Constants.h"
 #include "../Defs.h"
 #include "../Hittable.h"
 #include "../textures/TextureFactory.h"
 #include "Material.h"
 
+#include <algorithm>
+
 using nlohmann::json;
 
 namespace rt {
@@ -41,10 +44,21 @@ namespace rt {
         scatterDir = rec.normal;
 
       scattered   = Ray(rec.p, scatterDir, rIn.time);
-      attenuation = albedo->Value(rec.u, rec.v, rec.p);
+      attenuation = albedo->Sample(rec.u, rec.v, rec.p, rec.footprint);
       return true;
     }
 
+    // Diffuse bounces scatter over the whole hemisphere, so what follows is blurry anyway
+    virtual float scatterSpread(float incomingSpread) const override {
+      return std::max(incomingSpread, rt::constants::diffuseConeSpread);
+    }
+
+    // `scatter` picks cosine weighted directions around the normal
+    virtual float scatterPdf(const HitRecord &rec, const vec3 &direction) const override {
+      float cosTheta = vec3::DotProd(rec.normal, direction.Normalize());
+      return std::max(cosTheta, 0.0f) / rt::constants::pi;
+    }
+
     json toJson() const override { return json{{"type", "lambertian"}, {"texture", albedo->toJson()}}; }
 
     virtual void OnImgui() override {
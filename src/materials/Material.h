@@ -11,10 +11,20 @@ namespace rt {
 
   class Material : public IImguiDrawable {
   public:
-    virtual vec3 emitted(float u, float v, const vec3 &p) const { return vec3::Zero(); }
+    // `footprint` is the width of the incoming ray's cone at the hit, in uv units
+    virtual vec3 emitted(float u, float v, const vec3 &p, float footprint) const { return vec3::Zero(); }
 
     virtual bool scatter(const Ray &r_in, HitRecord &rec, vec3 &attenuation, Ray &scattered) const = 0;
 
+    // Spread of the cone of rays leaving the surface, given the spread of the incoming one.
+    // Mirror-like materials keep it, rough ones widen it.
+    virtual float scatterSpread(float incomingSpread) const { return incomingSpread; }
+
+    // Density `scatter` picks `direction` with, per unit solid angle. Only meaningful for materials
+    // whose attenuation times this density is their BSDF times the cosine term (diffuse ones).
+    // 0 means the material can't be sampled towards a light, so lights aren't sampled explicitly.
+    virtual float scatterPdf(const HitRecord &rec, const vec3 &direction) const { return 0.0f; }
+
     virtual json toJson() const = 0;
   };
 }; // namespace rt
@@ -24,10 +24,13 @@ namespace rt {
       vec3 inNormlized = r_in.direction.Normalize();
       vec3 reflected     = inNormlized.Reflect(rec.normal);
       scattered          = Ray(rec.p, reflected + vec3::RandomInUnitSphere() * fuzz, r_in.time);
-      attenuation        = albedo->Value(rec.u, rec.v, rec.p);
+      attenuation        = albedo->Sample(rec.u, rec.v, rec.p, rec.footprint);
       return (vec3::DotProd(scattered.direction, rec.normal) > 0);
     }
 
+    // Fuzzy reflections perturb directions by up to `fuzz`, widening the cone by about as much
+    virtual float scatterSpread(float incomingSpread) const override { return incomingSpread + fuzz; }
+
     json toJson() const override {
       return json{
           {"type", "metal"},
@@ -18,7 +18,7 @@ namespace rt {
     std::shared_ptr<Material> mp;
     float                     x0, x1, y0, y1, z;
 
-    XYRect() : Hittable("XY Rect") {}
+    XYRect() : Hittable("XY Rect", PrimitiveType::rect) {}
     XYRect(float _x0, float _x1, float _y0, float _y1, float _z, std::shared_ptr<Material> mat);
 
     json toJsonSpecific() const override;
@@ -33,7 +33,7 @@ namespace rt {
     std::shared_ptr<Material> mp;
     float                     x0, x1, z0, z1, y;
 
-    XZRect() : Hittable("XY Rect") {}
+    XZRect() : Hittable("XY Rect", PrimitiveType::rect) {}
     XZRect(float _x0, float _x1, float _z0, float _z1, float _y, std::shared_ptr<Material> mat);
 
     json toJsonSpecific() const override;
@@ -48,7 +48,7 @@ namespace rt {
     std::shared_ptr<Material> mp;
     float                     y0, y1, z0, z1, x;
 
-    YZRect() : Hittable("YZ Rect") {}
+    YZRect() : Hittable("YZ Rect", PrimitiveType::rect) {}
     YZRect(float _y0, float _y1, float _z0, float _z1, float _x, std::shared_ptr<Material> mat);
 
     json toJsonSpecific() const override;
@@ -13,9 +13,9 @@ namespace rt {
     float time0, time1;
     float radius;
 
-    MovingSphere() : Hittable("Moving Sphere") {}
+    MovingSphere() : Hittable("Moving Sphere", PrimitiveType::movingSphere) {}
     MovingSphere(vec3 c0, vec3 c1, float t0, float t1, float r, std::shared_ptr<Material> m)
-        : Hittable("Moving Sphere"), center0(c0), center1(c1), time0(t0), time1(t1), radius(r) {
+        : Hittable("Moving Sphere", PrimitiveType::movingSphere), center0(c0), center1(c1), time0(t0), time1(t1), radius(r) {
       this->material = m;
     }
 
@@ -52,11 +52,11 @@ namespace rt {
     bool BoundingBox(float t0, float t1, AABB &outputBox) const override;
   };
 
-  vec3 MovingSphere::CurrCenter(float time) const {
+  inline vec3 MovingSphere::CurrCenter(float time) const {
     return center0 + ((time - time0) / (time1 - time0)) * (center1 - center0);
   }
 
-  bool MovingSphere::BoundingBox(float t0, float t1, AABB &outputBox) const {
+  inline bool MovingSphere::BoundingBox(float t0, float t1, AABB &outputBox) const {
     AABB box0 = AABB(CurrCenter(t0) - vec3(radius), CurrCenter(t0) + vec3(radius));
 
     AABB box1 = AABB(CurrCenter(t1) - vec3(radius), CurrCenter(t1) + vec3(radius));
@@ -18,8 +18,8 @@ namespace rt {
     // |  / t1 |
     // |/______|
 
-    Plane() : Hittable("Plane") {}
-    Plane(float w, float h) : Hittable("Plane") { Create(w, h); }
+    Plane() : Hittable("Plane", PrimitiveType::plane) {}
+    Plane(float w, float h) : Hittable("Plane", PrimitiveType::plane) { Create(w, h); }
 
     void Create(float w, float h) {
       this->w = w;
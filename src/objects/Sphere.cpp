@@ -8,9 +8,9 @@
 #include <raymath.h>
 
 namespace rt {
-  Sphere::Sphere() : Hittable("Sphere") {}
+  Sphere::Sphere() : Hittable("Sphere", PrimitiveType::sphere) {}
 
-  Sphere::Sphere(float r) : Hittable("Sphere"), radius(r) {}
+  Sphere::Sphere(float r) : Hittable("Sphere", PrimitiveType::sphere), radius(r) {}
 
   Sphere::Sphere(float r, std::shared_ptr<Material> m) : Sphere(r) { material = m; }
 
@@ -44,6 +44,7 @@ namespace rt {
     const vec3 outwardNormal = (rec.p - center) / radius;
     rec.set_face_normal(r, outwardNormal);
     GetSphereUV(outwardNormal, rec.u, rec.v);
+    rec.uvScale    = UVScale(radius);
     rec.mat_ptr    = material;
     rec.closestHit = (Hittable *)this;
 
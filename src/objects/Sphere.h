@@ -23,6 +23,10 @@ namespace rt {
 
     void Rasterize(vec3 color) override;
 
+    // u covers the equator (2 pi r) and v a meridian (pi r). Texels of a lat-long map are as
+    // tall as they're wide, so the wider axis sizes them like it sizes the levels.
+    static float UVScale(float radius) { return 2.0f * PI * radius; }
+
   private:
     static void GetSphereUV(const vec3 &p, float &u, float &v);
   };
@@ -20,16 +20,16 @@ namespace rt {
     vert v0, v1, v2;
     vec3 normal;
 
-    Triangle() : Hittable("Triangle") {}
+    Triangle() : Hittable("Triangle", PrimitiveType::triangle) {}
 
-    Triangle(vert _v0, vert _v1, vert _v2) : Hittable("Triangle"), v0(_v0), v1(_v1), v2(_v2) {
+    Triangle(vert _v0, vert _v1, vert _v2) : Hittable("Triangle", PrimitiveType::triangle), v0(_v0), v1(_v1), v2(_v2) {
       vec3 v01 = (v1.p - v0.p).Normalize();
       vec3 v02 = (v2.p - v0.p).Normalize();
 
       normal = vec3::CrsProd(v01, v02).Normalize();
     }
 
-    Triangle(vec3 p0, vec3 p1, vec3 p2) : Hittable("Triangle"), v0(p0), v1(p1), v2(p2) {
+    Triangle(vec3 p0, vec3 p1, vec3 p2) : Hittable("Triangle", PrimitiveType::triangle), v0(p0), v1(p1), v2(p2) {
       vec3 v01 = (v1.p - v0.p).Normalize();
       vec3 v02 = (v2.p - v0.p).Normalize();
 
@@ -80,6 +80,7 @@ namespace rt {
 
         rec.u       = properUVs.x;
         rec.v       = properUVs.y;
+        rec.uvScale = UVScale();
         rec.mat_ptr = material;
         rec.t       = t;
         rec.set_face_normal(r, normal);
@@ -91,6 +92,14 @@ namespace rt {
       return false;
     }
 
+    // Square root of the triangle's area over its area in uv space
+    float UVScale() const {
+      float area   = vec3::CrsProd(v1.p - v0.p, v2.p - v0.p).Len();
+      float uvArea = std::fabs(vec3::CrsProd(v1.uvw - v0.uvw, v2.uvw - v0.uvw).z);
+
+      return uvArea > 0 ? std::sqrt(area / uvArea) : 0.0f;
+    }
+
     virtual bool BoundingBox(float t0, float t1, AABB &outputBox) const override {
       outputBox = transformation.regenAABB(AABB(std::vector<vec3>{{v0.p, v1.p, v2.p}}));
       return true;
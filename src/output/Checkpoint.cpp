@@ -0,0 +1,212 @@
+#include "Checkpoint.h"
+
+#include "../AsyncRenderData.h"
+#include "../Constants.h"
+#include "../Scene.h"
+#include "../TraceEvents.h"
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+namespace rt {
+  namespace {
+    constexpr char          magic[4] = {'R', 'T', 'C', 'K'};
+    constexpr std::uint32_t version  = 1;
+
+    struct Header {
+      char          magic[4];
+      std::uint32_t version;
+      std::int32_t  width, height, tileSize, tileOrder, planeCount;
+      std::uint32_t tileCount;
+      std::uint64_t sceneHash;
+    };
+  } // namespace
+
+  int Checkpoint::finishedTiles() const { return std::count(finished.begin(), finished.end(), 1); }
+
+  std::uint64_t SceneHash(Scene const &scene) {
+    std::string description =
+        scene.toJson().dump() + std::to_string(scene.imageWidth) + "x" + std::to_string(scene.imageHeight) +
+        scene.settings.debugViewDescription();
+
+    // Tiles outside of the crop are saved as finished without being rendered, so a checkpoint
+    // only resumes the same crop
+    if (auto const region = scene.cropRegion())
+      description += " crop " + std::to_string(region->x0) + "," + std::to_string(region->y0) + "," +
+                     std::to_string(region->x1) + "," + std::to_string(region->y1);
+
+    // FNV-1a, unlike std::hash it's guaranteed to be the same between runs
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : description) {
+      hash ^= c;
+      hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+  }
+
+  Checkpoint CaptureCheckpoint(AsyncRenderData const &ard, Scene const &scene) {
+    FrameBuffer const &fb    = ard.frameBuffer;
+    auto const        &tiles = fb.getTiles();
+
+    Checkpoint checkpoint;
+    checkpoint.width      = fb.getWidth();
+    checkpoint.height     = fb.getHeight();
+    checkpoint.tileSize   = constants::tileSize;
+    checkpoint.tileOrder  = fb.getTileOrder();
+    checkpoint.planeCount = fb.planeCount();
+    checkpoint.sceneHash  = SceneHash(scene);
+    checkpoint.finished.resize(tiles.size());
+
+    for (size_t i = 0; i < tiles.size(); i++) {
+      // Tiles finishing while this runs are picked up by the next checkpoint
+      if (!ard.isFinished(i))
+        continue;
+
+      checkpoint.finished[i] = 1;
+      for (int p = 0; p < fb.planeCount(); p++) {
+        float const *plane = fb.plane(p) + tiles[i].offset;
+        checkpoint.data.insert(checkpoint.data.end(), plane, plane + tiles[i].pixelCount());
+      }
+    }
+
+    return checkpoint;
+  }
+
+  bool SaveCheckpoint(std::string const &path, Checkpoint const &checkpoint) {
+    std::string const tempPath = path + ".tmp";
+
+    {
+      std::ofstream file(tempPath, std::ios::binary);
+      if (!file) {
+        std::cerr << "Failed to open " << tempPath << " for writing\n";
+        return false;
+      }
+
+      Header header{{magic[0], magic[1], magic[2], magic[3]},
+                    version,
+                    checkpoint.width,
+                    checkpoint.height,
+                    checkpoint.tileSize,
+                    static_cast<std::int32_t>(checkpoint.tileOrder),
+                    checkpoint.planeCount,
+                    static_cast<std::uint32_t>(checkpoint.finished.size()),
+                    checkpoint.sceneHash};
+
+      file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+      file.write(reinterpret_cast<char const *>(checkpoint.finished.data()), checkpoint.finished.size());
+      file.write(reinterpret_cast<char const *>(checkpoint.data.data()), checkpoint.data.size() * sizeof(float));
+
+      if (!file.flush())
+        return false;
+    }
+
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+  }
+
+  std::optional<Checkpoint> LoadCheckpoint(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "Failed to open checkpoint " << path << '\n';
+      return std::nullopt;
+    }
+
+    Header header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || !std::equal(magic, magic + 4, header.magic) ||
+        header.version != version) {
+      std::cerr << path << " isn't a checkpoint this version can read\n";
+      return std::nullopt;
+    }
+
+    // Everything after the finished flags is tile data, a corrupt count mustn't allocate past it
+    std::streamoff const headerEnd = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff const fileSize = file.tellg();
+    file.seekg(headerEnd);
+
+    if (header.tileCount > std::uint64_t(fileSize - headerEnd)) {
+      std::cerr << "Checkpoint " << path << " is truncated\n";
+      return std::nullopt;
+    }
+
+    Checkpoint checkpoint;
+    checkpoint.width      = header.width;
+    checkpoint.height     = header.height;
+    checkpoint.tileSize   = header.tileSize;
+    checkpoint.tileOrder  = static_cast<TraversalOrder>(header.tileOrder);
+    checkpoint.planeCount = header.planeCount;
+    checkpoint.sceneHash  = header.sceneHash;
+
+    checkpoint.finished.resize(header.tileCount);
+    if (!file.read(reinterpret_cast<char *>(checkpoint.finished.data()), checkpoint.finished.size())) {
+      std::cerr << "Checkpoint " << path << " is truncated\n";
+      return std::nullopt;
+    }
+
+    // Tile sizes are only known once the layout is rebuilt, so the data is read up to the end
+    // and checked against them in `RestoreCheckpoint`
+    checkpoint.data.resize((fileSize - headerEnd - header.tileCount) / sizeof(float));
+    if (!file.read(reinterpret_cast<char *>(checkpoint.data.data()), checkpoint.data.size() * sizeof(float))) {
+      std::cerr << "Checkpoint " << path << " is truncated\n";
+      return std::nullopt;
+    }
+
+    return checkpoint;
+  }
+
+  bool RestoreCheckpoint(Checkpoint const &checkpoint, AsyncRenderData &ard, Scene const &scene) {
+    FrameBuffer &fb    = ard.frameBuffer;
+    auto const  &tiles = fb.getTiles();
+
+    if (checkpoint.sceneHash != SceneHash(scene)) {
+      std::cerr << "Checkpoint was taken from a different scene or with different settings\n";
+      return false;
+    }
+
+    if (checkpoint.width != fb.getWidth() || checkpoint.height != fb.getHeight() ||
+        checkpoint.tileSize != constants::tileSize || checkpoint.tileOrder != fb.getTileOrder() ||
+        checkpoint.planeCount != fb.planeCount() || checkpoint.finished.size() != tiles.size()) {
+      std::cerr << "Checkpoint doesn't match the framebuffer's layout (resolution, traversal order or AOVs)\n";
+      return false;
+    }
+
+    std::size_t expected = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+      if (checkpoint.finished[i])
+        expected += std::size_t(tiles[i].pixelCount()) * fb.planeCount();
+    }
+
+    if (expected != checkpoint.data.size()) {
+      std::cerr << "Checkpoint is truncated\n";
+      return false;
+    }
+
+    float const *in = checkpoint.data.data();
+    for (size_t i = 0; i < tiles.size(); i++) {
+      if (!checkpoint.finished[i])
+        continue;
+
+      for (int p = 0; p < fb.planeCount(); p++) {
+        std::copy_n(in, tiles[i].pixelCount(), fb.plane(p) + tiles[i].offset);
+        in += tiles[i].pixelCount();
+      }
+
+      ard.markFinished(tiles[i]);
+    }
+
+    ard.skipFinishedTiles();
+    return true;
+  }
+
+  void SubmitCheckpoint(ImageWriter &writer, AsyncRenderData const &ard, Scene const &scene, std::string const &path) {
+    TraceScope const trace("Capture checkpoint");
+
+    auto checkpoint = std::make_shared<Checkpoint>(CaptureCheckpoint(ard, scene));
+    writer.submit(path, [path, checkpoint] { return SaveCheckpoint(path, *checkpoint); });
+  }
+} // namespace rt
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../data_structures/TraversalOrder.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rt {
+  struct AsyncRenderData;
+  class ImageWriter;
+  class Scene;
+
+  /**
+   * @brief Snapshot of a render in progress: which tiles are finished and their pixels.
+   *
+   * Tiles are rendered with all their samples at once and seeded by their position, so a finished
+   * tile is final and an unfinished one can be rendered from scratch on resume with the same
+   * result. That's why no per-pixel sample counts or RNG states need to be stored.
+   *
+   * On disk: a header, one byte per tile (in framebuffer order) telling whether it's finished,
+   * then every finished tile's planes one after another as raw floats.
+   */
+  struct Checkpoint {
+    int            width = 0, height = 0, tileSize = 0;
+    TraversalOrder tileOrder = TraversalOrder::scanline;
+    int            planeCount = 0;
+
+    // Resuming with a different scene or settings would mix two different images
+    std::uint64_t sceneHash = 0;
+
+    std::vector<std::uint8_t> finished;
+    std::vector<float>        data;
+
+    int finishedTiles() const;
+  };
+
+  // Hash of everything that changes the rendered image: the scene's JSON, the resolution, the
+  // debug view and the crop region if any
+  std::uint64_t SceneHash(Scene const &scene);
+
+  // Copies the tiles finished so far. Safe while the render is running, it only reads finished
+  // tiles, but must not race with `AsyncRenderData::reset`.
+  Checkpoint CaptureCheckpoint(AsyncRenderData const &ard, Scene const &scene);
+
+  // Writes to a temporary file first and renames it over `path`, so a crash mid-write keeps
+  // the previous checkpoint intact
+  bool SaveCheckpoint(std::string const &path, Checkpoint const &checkpoint);
+
+  std::optional<Checkpoint> LoadCheckpoint(std::string const &path);
+
+  // Writes the checkpoint's tiles into the framebuffer and removes them from the job queues.
+  // Call after `AsyncRenderData::reset` and before submitting the render. Fails (and leaves
+  // `ard` alone) if the checkpoint was taken from a different scene or buffer layout.
+  bool RestoreCheckpoint(Checkpoint const &checkpoint, AsyncRenderData &ard, Scene const &scene);
+
+  // Captures a checkpoint now and saves it on `writer`'s thread
+  void SubmitCheckpoint(ImageWriter &writer, AsyncRenderData const &ard, Scene const &scene, std::string const &path);
+} // namespace rt
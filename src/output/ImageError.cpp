@@ -0,0 +1,100 @@
+#include "ImageError.h"
+
+#include "ImageOutput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace rt {
+  namespace {
+    // Channel value as the raytracer view and bmp output show it
+    float Displayed(float value) {
+#ifdef GAMMA_CORRECTION
+      value = std::sqrt(std::max(value, 0.0f));
+#endif
+
+      return std::clamp(value, 0.0f, 1.0f);
+    }
+
+    // Displayed image blurred with a 3x3 binomial kernel (edges clamped), for the fine noise a
+    // viewer doesn't resolve
+    std::vector<float> DisplayedBlurred(std::vector<float> const &rgb, int width, int height) {
+      int const weights[3] = {1, 2, 1};
+
+      std::vector<float> out(rgb.size());
+      for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+          for (int c = 0; c < 3; c++) {
+            float sum = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+              for (int dx = -1; dx <= 1; dx++) {
+                int const sx = std::clamp(x + dx, 0, width - 1), sy = std::clamp(y + dy, 0, height - 1);
+                sum += weights[dx + 1] * weights[dy + 1] * Displayed(rgb[(std::size_t(sy) * width + sx) * 3 + c]);
+              }
+            }
+
+            out[(std::size_t(y) * width + x) * 3 + c] = sum / 16;
+          }
+        }
+      }
+
+      return out;
+    }
+
+    struct Lab {
+      float l, a, b;
+    };
+
+    // sRGB encoded color to CIELAB, D65 white point
+    Lab ToLab(float const *rgb) {
+      auto const linear = [](float c) { return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f); };
+      float const r = linear(rgb[0]), g = linear(rgb[1]), b = linear(rgb[2]);
+
+      float const x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+      float const y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+      float const z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+
+      auto const f = [](float t) { return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116; };
+      return {116 * f(y) - 16, 500 * (f(x) - f(y)), 200 * (f(y) - f(z))};
+    }
+  } // namespace
+
+  std::optional<ImageError> CompareImages(OutputImage const &image, OutputImage const &reference) {
+    if (image.width != reference.width || image.height != reference.height || image.layers.empty() ||
+        reference.layers.empty())
+      return std::nullopt;
+
+    auto const &x = image.layers.front().data;
+    auto const &r = reference.layers.front().data;
+    if (x.size() != r.size() || x.empty())
+      return std::nullopt;
+
+    ImageError error{};
+
+    double squared = 0, relative = 0;
+    for (std::size_t i = 0; i < x.size(); i++) {
+      double const d = double(x[i]) - r[i];
+      squared += d * d;
+      relative += d * d / (double(r[i]) * r[i] + 0.01);
+      error.maxAbs = std::max(error.maxAbs, std::abs(d));
+    }
+
+    error.rmse   = std::sqrt(squared / x.size());
+    error.relMse = relative / x.size();
+
+    auto const shown    = DisplayedBlurred(x, image.width, image.height);
+    auto const expected = DisplayedBlurred(r, image.width, image.height);
+
+    // CIELAB differences go up to about 100 between black and white
+    double difference = 0;
+    for (std::size_t p = 0; p < shown.size(); p += 3) {
+      Lab const a = ToLab(&shown[p]), b = ToLab(&expected[p]);
+      double const deltaE = std::sqrt((a.l - b.l) * (a.l - b.l) + (a.a - b.a) * (a.a - b.a) + (a.b - b.b) * (a.b - b.b));
+      difference += std::min(deltaE / 100, 1.0);
+    }
+
+    error.flipLike = difference / (shown.size() / 3);
+    return error;
+  }
+} // namespace rt
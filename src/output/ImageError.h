@@ -0,0 +1,26 @@
+#pragma once
+
+#include <optional>
+
+namespace rt {
+  struct OutputImage;
+
+  /**
+   * @brief How far a render is from a reference of the same scene, comparing their beauty passes.
+   */
+  struct ImageError {
+    double rmse;   // Root mean squared error over all channels, in linear radiance
+    double relMse; // Mean of (x - ref)^2 / (ref^2 + 0.01), so dark pixels weigh as much as bright ones
+
+    // Mean CIELAB color difference of the displayed images (clamped, gamma corrected if enabled)
+    // after a 3x3 blur, scaled to [0, 1]. In the spirit of FLIP, judging what a viewer sees
+    // rather than the raw values, but much simpler than it.
+    double flipLike;
+
+    // Largest absolute difference of a single channel
+    double maxAbs;
+  };
+
+  // No value if the images differ in size
+  std::optional<ImageError> CompareImages(OutputImage const &image, OutputImage const &reference);
+} // namespace rt
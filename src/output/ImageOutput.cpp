@@ -0,0 +1,310 @@
+#include "ImageOutput.h"
+
+#include "../data_structures/FrameBuffer.h"
+
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// Both formats are written by dumping floats and ints as they are in memory
+static_assert(std::endian::native == std::endian::little, "Image output assumes a little endian host");
+
+namespace rt {
+  namespace {
+    template<typename T> void Append(std::vector<char> &out, T const &value) {
+      char const *bytes = reinterpret_cast<char const *>(&value);
+      out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void AppendString(std::vector<char> &out, std::string const &str) {
+      out.insert(out.end(), str.begin(), str.end());
+      out.push_back('\0');
+    }
+
+    // EXR header attribute: name, type name, value size, value
+    void AppendAttribute(std::vector<char> &out, std::string const &name, std::string const &type,
+                         std::vector<char> const &value) {
+      AppendString(out, name);
+      AppendString(out, type);
+      Append(out, static_cast<std::int32_t>(value.size()));
+      out.insert(out.end(), value.begin(), value.end());
+    }
+
+    std::string LayerPath(std::string const &path, ImageLayer const &layer) {
+      if (layer.name.empty())
+        return path;
+
+      auto const slash = path.find_last_of('/');
+      auto const dot   = path.find_last_of('.');
+      if (dot == std::string::npos || (slash != std::string::npos && slash > dot))
+        return path + "." + layer.name;
+
+      return path.substr(0, dot) + "." + layer.name + path.substr(dot);
+    }
+  } // namespace
+
+  std::string TimestampedRenderPath(int width, int height, int samplesPerPixel, int maxDepth, OutputFormat format) {
+    std::stringstream ss;
+
+    auto t  = std::time(nullptr);
+    auto tm = *std::localtime(&t);
+    ss << "screenshots/" << std::put_time(&tm, "%d-%m-%Y %H-%M-%S") << "_" << width << "x" << height << "_"
+       << samplesPerPixel << "_" << maxDepth << "." << outputFormatLabels[static_cast<int>(format)];
+
+    return ss.str();
+  }
+
+  OutputImage Snapshot(FrameBuffer const &fb) {
+    int const width = fb.getWidth(), height = fb.getHeight();
+
+    OutputImage image{width, height, {{"", {"R", "G", "B"}, {}}}};
+    if (fb.hasAovs()) {
+      image.layers.push_back({"albedo", {"R", "G", "B"}, {}});
+      image.layers.push_back({"normal", {"X", "Y", "Z"}, {}});
+      image.layers.push_back({"depth", {"Z"}, {}});
+    }
+
+    for (auto &layer : image.layers)
+      layer.data.resize(std::size_t(width) * height * layer.channels.size());
+
+    for (auto const &tile : fb.getTiles()) {
+      for (int y = tile.y0; y < tile.y1; y++) {
+        // The framebuffer's y = 0 is the bottom row
+        std::size_t const row = std::size_t(height - 1 - y) * width;
+
+        for (int x = tile.x0; x < tile.x1; x++) {
+          int const         index = tile.offset + (y - tile.y0) * tile.width() + (x - tile.x0);
+          std::size_t const out   = row + x;
+
+          vec3 const color = fb.get(index);
+          std::copy_n(&color.x, 3, &image.layers[0].data[out * 3]);
+
+          if (fb.hasAovs()) {
+            auto const aovs = fb.getAovs(index);
+            std::copy_n(&aovs.albedo.x, 3, &image.layers[1].data[out * 3]);
+            std::copy_n(&aovs.normal.x, 3, &image.layers[2].data[out * 3]);
+            image.layers[3].data[out] = aovs.depth;
+          }
+        }
+      }
+    }
+
+    return image;
+  }
+
+  std::vector<char> ExrHeader(std::vector<std::string> const &channelNames, int width, int height, int tileSize) {
+    std::vector<char> header;
+    Append(header, std::int32_t(20000630));                    // Magic number
+    Append(header, std::int32_t(tileSize > 0 ? 0x202 : 0x2)); // Version 2, single part, tiled flag
+
+    std::vector<char> value;
+    for (auto const &name : channelNames) {
+      AppendString(value, name);
+      Append(value, std::int32_t(2)); // FLOAT
+      Append(value, std::int32_t(0)); // pLinear and reserved bytes
+      Append(value, std::int32_t(1)); // x sampling
+      Append(value, std::int32_t(1)); // y sampling
+    }
+    value.push_back('\0');
+    AppendAttribute(header, "channels", "chlist", value);
+
+    AppendAttribute(header, "compression", "compression", {'\0'});
+
+    value.clear();
+    for (std::int32_t v : {0, 0, width - 1, height - 1})
+      Append(value, v);
+    AppendAttribute(header, "dataWindow", "box2i", value);
+    AppendAttribute(header, "displayWindow", "box2i", value);
+
+    // Scanlines are written top to bottom, tiles in whatever order they finish
+    AppendAttribute(header, "lineOrder", "lineOrder", {tileSize > 0 ? '\2' : '\0'});
+
+    value.clear();
+    Append(value, 1.0f);
+    AppendAttribute(header, "pixelAspectRatio", "float", value);
+    AppendAttribute(header, "screenWindowWidth", "float", value);
+
+    value.clear();
+    Append(value, 0.0f);
+    Append(value, 0.0f);
+    AppendAttribute(header, "screenWindowCenter", "v2f", value);
+
+    if (tileSize > 0) {
+      value.clear();
+      Append(value, std::uint32_t(tileSize));
+      Append(value, std::uint32_t(tileSize));
+      value.push_back('\0'); // One level, rounding down
+      AppendAttribute(header, "tiles", "tiledesc", value);
+    }
+
+    header.push_back('\0'); // End of header
+    return header;
+  }
+
+  bool WriteEXR(std::string const &path, OutputImage const &image) {
+    struct Channel {
+      std::string  name;
+      float const *data;
+      int          stride;
+    };
+
+    std::vector<Channel> channels;
+    for (auto const &layer : image.layers) {
+      int const stride = layer.channels.size();
+      for (int c = 0; c < stride; c++) {
+        std::string name = layer.name.empty() ? layer.channels[c] : layer.name + "." + layer.channels[c];
+        channels.push_back({name, layer.data.data() + c, stride});
+      }
+    }
+
+    // Readers expect the channel list sorted by name, pixel data follows the same order
+    std::sort(channels.begin(), channels.end(), [](auto const &a, auto const &b) { return a.name < b.name; });
+
+    std::vector<std::string> names;
+    for (auto const &channel : channels)
+      names.push_back(channel.name);
+
+    std::vector<char> const header = ExrHeader(names, image.width, image.height);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "Failed to open " << path << " for writing\n";
+      return false;
+    }
+
+    file.write(header.data(), header.size());
+
+    // Uncompressed scanline blocks hold one line each, so every block has the same size
+    std::int32_t const  lineBytes  = image.width * channels.size() * sizeof(float);
+    std::uint64_t const tableStart = header.size();
+    std::uint64_t const firstBlock = tableStart + std::uint64_t(image.height) * sizeof(std::uint64_t);
+
+    for (std::uint64_t y = 0; y < std::uint64_t(image.height); y++) {
+      std::uint64_t offset = firstBlock + y * (2 * sizeof(std::int32_t) + lineBytes);
+      file.write(reinterpret_cast<char const *>(&offset), sizeof(offset));
+    }
+
+    std::vector<float> line(image.width * channels.size());
+    for (std::int32_t y = 0; y < image.height; y++) {
+      float *out = line.data();
+      for (auto const &channel : channels) {
+        float const *in = channel.data + std::size_t(y) * image.width * channel.stride;
+        for (int x = 0; x < image.width; x++)
+          *out++ = in[x * channel.stride];
+      }
+
+      file.write(reinterpret_cast<char const *>(&y), sizeof(y));
+      file.write(reinterpret_cast<char const *>(&lineBytes), sizeof(lineBytes));
+      file.write(reinterpret_cast<char const *>(line.data()), lineBytes);
+    }
+
+    return bool(file);
+  }
+
+  bool WritePFM(std::string const &path, OutputImage const &image) {
+    bool written = true;
+
+    for (auto const &layer : image.layers) {
+      int const channels = layer.channels.size();
+      if (channels != 1 && channels != 3)
+        continue;
+
+      std::string const layerPath = LayerPath(path, layer);
+
+      std::ofstream file(layerPath, std::ios::binary);
+      if (!file) {
+        std::cerr << "Failed to open " << layerPath << " for writing\n";
+        written = false;
+        continue;
+      }
+
+      // Negative scale means little endian. Rows are stored from the bottom up.
+      file << (channels == 3 ? "PF" : "Pf") << '\n' << image.width << ' ' << image.height << "\n-1.0\n";
+
+      std::size_t const rowFloats = std::size_t(image.width) * channels;
+      for (int y = image.height - 1; y >= 0; y--)
+        file.write(reinterpret_cast<char const *>(layer.data.data() + y * rowFloats), rowFloats * sizeof(float));
+
+      written = written && bool(file);
+    }
+
+    return written;
+  }
+
+  std::optional<OutputImage> ReadPFM(std::string const &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return std::nullopt;
+
+    std::string magic;
+    OutputImage image;
+    float       scale = 0;
+    file >> magic >> image.width >> image.height >> scale;
+
+    // A single whitespace character separates the header from the pixels
+    file.get();
+
+    if (!file || (magic != "PF" && magic != "Pf") || image.width <= 0 || image.height <= 0 || scale >= 0) {
+      std::cerr << "Not a little endian PFM: " << path << '\n';
+      return std::nullopt;
+    }
+
+    int const         channels  = magic == "PF" ? 3 : 1;
+    std::size_t const rowFloats = std::size_t(image.width) * channels;
+
+    std::vector<float> data(rowFloats * image.height);
+    for (int y = image.height - 1; y >= 0; y--)
+      file.read(reinterpret_cast<char *>(data.data() + y * rowFloats), rowFloats * sizeof(float));
+
+    if (!file) {
+      std::cerr << "Truncated PFM: " << path << '\n';
+      return std::nullopt;
+    }
+
+    ImageLayer beauty{"", {"R", "G", "B"}, {}};
+    if (channels == 3) {
+      beauty.data = std::move(data);
+    } else {
+      beauty.data.reserve(data.size() * 3);
+      for (float value : data)
+        beauty.data.insert(beauty.data.end(), {value, value, value});
+    }
+
+    image.layers.push_back(std::move(beauty));
+    return image;
+  }
+
+  bool WriteBMP(std::string const &path, OutputImage const &image) {
+    auto const &beauty = image.layers.front();
+
+    std::vector<unsigned char> pixels(beauty.data.size());
+    for (std::size_t i = 0; i < pixels.size(); i++) {
+      float value = beauty.data[i];
+
+#ifdef GAMMA_CORRECTION
+      value = std::sqrt(value);
+#endif
+
+      pixels[i] = static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255);
+    }
+
+    return stbi_write_bmp(path.c_str(), image.width, image.height, 3, pixels.data()) != 0;
+  }
+
+  bool WriteImage(std::string const &path, OutputFormat format, OutputImage const &image) {
+    switch (format) {
+    case OutputFormat::pfm: return WritePFM(path, image);
+    case OutputFormat::exr: return WriteEXR(path, image);
+    default: return WriteBMP(path, image);
+    }
+  }
+} // namespace rt
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rt {
+  class FrameBuffer;
+
+  enum class OutputFormat { bmp, pfm, exr, outputFormatsCount };
+
+  inline static const char *outputFormatLabels[] = {"bmp", "pfm", "exr"};
+
+  // A named group of channels, e.g. "albedo" with R, G, B. Samples are interleaved and rows go
+  // from the top of the image down.
+  struct ImageLayer {
+    std::string              name; // Empty for the beauty pass
+    std::vector<std::string> channels;
+    std::vector<float>       data;
+  };
+
+  /**
+   * @brief Linear float copy of a render, decoupled from the framebuffer so it can be encoded
+   * on another thread while the next render overwrites the buffer.
+   */
+  struct OutputImage {
+    int                     width = 0, height = 0;
+    std::vector<ImageLayer> layers; // The beauty pass first, then the AOVs if any
+  };
+
+  // "screenshots/<date> <time>_<width>x<height>_<spp>_<depth>.<format>"
+  std::string TimestampedRenderPath(int width, int height, int samplesPerPixel, int maxDepth, OutputFormat format);
+
+  // Copies the framebuffer (and its AOVs) into row-major layers
+  OutputImage Snapshot(FrameBuffer const &fb);
+
+  // Single part, uncompressed scanline OpenEXR with one 32 bit float channel per layer channel,
+  // AOV channels are prefixed with their layer's name ("albedo.R")
+  bool WriteEXR(std::string const &path, OutputImage const &image);
+
+  // Header of an uncompressed, single part OpenEXR file with 32 bit float channels, ending with
+  // the null byte before the offset table. `channelNames` must be sorted. Tiled (one level) if
+  // `tileSize` > 0, scanline otherwise.
+  std::vector<char> ExrHeader(std::vector<std::string> const &channelNames, int width, int height, int tileSize = 0);
+
+  // PFM holds a single layer, AOVs go next to `path` with their name before the extension
+  // ("render.albedo.pfm")
+  bool WritePFM(std::string const &path, OutputImage const &image);
+
+  // Reads a little endian PFM (as written by `WritePFM`) into a single layer, grayscale ones
+  // expanded to RGB. No value if the file can't be read.
+  std::optional<OutputImage> ReadPFM(std::string const &path);
+
+  // 8 bit, gamma corrected (if enabled) beauty pass only
+  bool WriteBMP(std::string const &path, OutputImage const &image);
+
+  bool WriteImage(std::string const &path, OutputFormat format, OutputImage const &image);
+} // namespace rt
@@ -0,0 +1,83 @@
+#include "ImageWriter.h"
+
+#include "../TraceEvents.h"
+
+#include <iostream>
+
+namespace rt {
+  ImageWriter::ImageWriter() : writer(&ImageWriter::writerLoop, this) {}
+
+  ImageWriter::~ImageWriter() {
+    {
+      std::lock_guard lock(queueMutex);
+      stopping = true;
+    }
+
+    wakeWriter.notify_one();
+    writer.join();
+  }
+
+  void ImageWriter::submit(std::string path, OutputFormat format, OutputImage image) {
+    auto write = [path, format, image = std::move(image)] { return WriteImage(path, format, image); };
+    submit(std::move(path), std::move(write));
+  }
+
+  void ImageWriter::submit(std::string path, std::function<bool()> write) {
+    pendingJobs.fetch_add(1, std::memory_order_relaxed);
+
+    {
+      std::lock_guard lock(queueMutex);
+      jobs.push_back({std::move(path), std::move(write)});
+    }
+
+    wakeWriter.notify_one();
+  }
+
+  bool ImageWriter::drain() {
+    std::unique_lock lock(queueMutex);
+    jobDone.wait(lock, [this] { return pendingJobs.load(std::memory_order_relaxed) == 0; });
+
+    bool const succeeded = failedJobs == 0;
+    failedJobs           = 0;
+    return succeeded;
+  }
+
+  void ImageWriter::writerLoop() {
+    TraceEvents::NameThread("Image writer");
+
+    while (true) {
+      Job job;
+
+      {
+        std::unique_lock lock(queueMutex);
+        wakeWriter.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+        // Drain the queue before stopping, a render shouldn't be lost because the app quit
+        if (jobs.empty())
+          return;
+
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+
+      bool written;
+      {
+        TraceScope const trace("Write image");
+        written = job.write();
+      }
+
+      if (written)
+        std::cout << "Wrote " << job.path << '\n';
+      else
+        std::cerr << "Failed to write " << job.path << '\n';
+
+      {
+        std::lock_guard lock(queueMutex);
+        failedJobs += written ? 0 : 1;
+        pendingJobs.fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      jobDone.notify_all();
+    }
+  }
+} // namespace rt
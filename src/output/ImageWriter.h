@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ImageOutput.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rt {
+  /**
+   * @brief Encodes and writes images (and checkpoints) on a background thread, so neither the
+   * UI nor the render waits on disk or on the encoder. Files are written in the order they're
+   * submitted, and the destructor finishes writing whatever is still queued.
+   */
+  class ImageWriter {
+  public:
+    ImageWriter();
+    ~ImageWriter();
+
+    ImageWriter(ImageWriter const &)            = delete;
+    ImageWriter &operator=(ImageWriter const &) = delete;
+
+    void submit(std::string path, OutputFormat format, OutputImage image);
+
+    // `write` runs on the writer's thread and returns whether `path` was written
+    void submit(std::string path, std::function<bool()> write);
+
+    // Files submitted but not written yet
+    int pending() const { return pendingJobs.load(std::memory_order_relaxed); }
+
+    // Waits until everything submitted so far is written. Returns false if any file written
+    // since the previous call failed.
+    bool drain();
+
+  private:
+    struct Job {
+      std::string           path;
+      std::function<bool()> write;
+    };
+
+    void writerLoop();
+
+    std::mutex              queueMutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable jobDone;
+    std::deque<Job>         jobs;
+    bool                    stopping    = false;
+    int                     failedJobs  = 0; // Since the last `drain`
+    std::atomic<int>        pendingJobs = 0;
+
+    std::thread writer; // Last, so it starts after everything it uses is constructed
+  };
+} // namespace rt
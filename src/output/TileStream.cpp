@@ -0,0 +1,113 @@
+#include "TileStream.h"
+
+#include "../data_structures/FrameBuffer.h"
+#include "ImageOutput.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+namespace rt {
+  namespace {
+    // Names of the framebuffer's planes, the same names `WriteEXR` gives them
+    const char *planeChannelNames[] = {"R",        "G",        "B",        "albedo.R", "albedo.G",
+                                       "albedo.B", "normal.X", "normal.Y", "normal.Z", "depth.Z"};
+
+    bool WriteAt(int fd, void const *data, std::size_t size, std::uint64_t offset) {
+      char const *bytes = static_cast<char const *>(data);
+      while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written <= 0)
+          return false;
+
+        bytes += written;
+        size -= written;
+        offset += written;
+      }
+
+      return true;
+    }
+  } // namespace
+
+  sPtr<TiledExrStream> TiledExrStream::Open(std::string const &path, int width, int height, int tileSize,
+                                            int planeCount) {
+    sPtr<TiledExrStream> stream(new TiledExrStream());
+    stream->width    = width;
+    stream->height   = height;
+    stream->tileSize = tileSize;
+    stream->tilesX   = (width + tileSize - 1) / tileSize;
+
+    // Readers expect the channels sorted by name
+    stream->channelPlanes.resize(planeCount);
+    std::iota(stream->channelPlanes.begin(), stream->channelPlanes.end(), 0);
+    std::sort(stream->channelPlanes.begin(), stream->channelPlanes.end(),
+              [](int a, int b) { return std::strcmp(planeChannelNames[a], planeChannelNames[b]) < 0; });
+
+    std::vector<std::string> names;
+    for (int plane : stream->channelPlanes)
+      names.push_back(planeChannelNames[plane]);
+
+    std::vector<char> const header = ExrHeader(names, width, height, tileSize);
+
+    // Chunks follow the offset table in row-major tile order, each sized for its (maybe partial) tile
+    int const     tilesY = (height + tileSize - 1) / tileSize;
+    std::uint64_t offset = header.size() + std::uint64_t(stream->tilesX) * tilesY * sizeof(std::uint64_t);
+    for (int ty = 0; ty < tilesY; ty++) {
+      for (int tx = 0; tx < stream->tilesX; tx++) {
+        std::uint64_t const tileWidth  = std::min(tileSize, width - tx * tileSize);
+        std::uint64_t const tileHeight = std::min(tileSize, height - ty * tileSize);
+
+        stream->offsets.push_back(offset);
+        offset += 5 * sizeof(std::int32_t) + tileWidth * tileHeight * planeCount * sizeof(float);
+      }
+    }
+
+    stream->fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (stream->fd < 0) {
+      std::cerr << "Failed to open " << path << " for writing\n";
+      return nullptr;
+    }
+
+    if (!WriteAt(stream->fd, header.data(), header.size(), 0) ||
+        !WriteAt(stream->fd, stream->offsets.data(), stream->offsets.size() * sizeof(std::uint64_t), header.size())) {
+      std::cerr << "Failed to write the header of " << path << '\n';
+      return nullptr;
+    }
+
+    return stream;
+  }
+
+  TiledExrStream::~TiledExrStream() {
+    if (fd >= 0)
+      close(fd);
+  }
+
+  void TiledExrStream::writeTile(Tile const &tile, FrameBuffer const &pixels) {
+    int const tw = tile.width(), th = tile.height();
+
+    // Tile coordinates, level 0 in both directions, data size, then the data: each row holds
+    // each channel's values one after another
+    static thread_local std::vector<char> chunk;
+    chunk.resize(5 * sizeof(std::int32_t) + std::size_t(tw) * th * channelPlanes.size() * sizeof(float));
+
+    std::int32_t const header[5] = {tile.x0 / tileSize, tile.y0 / tileSize, 0, 0,
+                                    std::int32_t(chunk.size() - 5 * sizeof(std::int32_t))};
+    std::memcpy(chunk.data(), header, sizeof(header));
+
+    char *out = chunk.data() + sizeof(header);
+    for (int dy = 0; dy < th; dy++) {
+      for (int plane : channelPlanes) {
+        std::memcpy(out, pixels.plane(plane) + dy * tw, tw * sizeof(float));
+        out += tw * sizeof(float);
+      }
+    }
+
+    int const tileIndex = (tile.y0 / tileSize) * tilesX + tile.x0 / tileSize;
+    if (!WriteAt(fd, chunk.data(), chunk.size(), offsets[tileIndex]))
+      failed.store(true, std::memory_order_relaxed);
+  }
+} // namespace rt
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../Defs.h"
+#include "../data_structures/Tile.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rt {
+  class FrameBuffer;
+
+  /**
+   * @brief Destination for tiles as soon as they're rendered, for frames too large to keep in memory.
+   */
+  class TileSink {
+  public:
+    virtual ~TileSink() = default;
+
+    // Called by the render workers, concurrently, once per finished tile. `pixels` holds the
+    // tile's planes starting at index 0, with rows going from the top of the image down.
+    virtual void writeTile(Tile const &tile, FrameBuffer const &pixels) = 0;
+
+    // False once any tile failed to be written
+    virtual bool ok() const = 0;
+  };
+
+  /**
+   * @brief Writes tiles straight into a tiled, uncompressed OpenEXR file.
+   *
+   * Every tile's chunk has a fixed size, so the header and offset table are written up front and
+   * each tile goes to its final place in the file with a single positioned write, in any order
+   * and from any thread. Only the tile being written is ever in memory.
+   * Tiles are `tileSize` squares from the top left corner, matching `FrameBuffer`'s tiles when
+   * their y axis is taken to go down.
+   */
+  class TiledExrStream : public TileSink {
+  public:
+    // `planeCount` is 3 for color only, or 10 with the AOV planes. Returns nullptr if the file
+    // can't be created.
+    static sPtr<TiledExrStream> Open(std::string const &path, int width, int height, int tileSize, int planeCount);
+
+    TiledExrStream(TiledExrStream const &)            = delete;
+    TiledExrStream &operator=(TiledExrStream const &) = delete;
+
+    ~TiledExrStream() override;
+
+    void writeTile(Tile const &tile, FrameBuffer const &pixels) override;
+
+    bool ok() const override { return !failed.load(std::memory_order_relaxed); }
+
+  private:
+    TiledExrStream() = default;
+
+    int fd = -1;
+    int width = 0, height = 0, tileSize = 0, tilesX = 0;
+
+    std::vector<int>           channelPlanes; // Framebuffer plane of each channel, in the file's (sorted) order
+    std::vector<std::uint64_t> offsets;       // File offset of each tile's chunk, row-major
+
+    std::atomic<bool> failed = false;
+  };
+} // namespace rt
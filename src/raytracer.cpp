@@ -1,11 +1,15 @@
 #include "raytracer.h"
 
 #include "IState.h"
-#include "data_structures/Pixel.h"
+#include "TraceEvents.h"
 #include "editor/Utils.h"
+#include "output/Checkpoint.h"
+#include "output/ImageOutput.h"
+#include "textures/TileCache.h"
 
 #include <imgui.h>
 
+#include <algorithm>
 #include <iostream>
 #include <raylib.h>
 
@@ -14,22 +18,8 @@ rt::Raytracer::Raytracer(App *const app, AsyncRenderData &ard) : IState(app), ar
 void rt::Raytracer::onEnter() { startRaytracing(); }
 
 void rt::Raytracer::onExit() {
-  ard.KillThreads();
-
-  // Reset job queue chunks
-  ard.pixelJobs->setCurrentChunkStart(0);
-
-  // Reset thread times and progress
-  for (int i = 0; i < app->getNumThreads(); i++) {
-    ard.threadTimes[i]     = 0;
-    ard.threadProgress[i]  = 0;
-    ard.finishedThreads[i] = false;
-  }
-
-  // Clear results from previous job.
-  for (auto it = ard.pixelJobs->getJobsVector().begin(); it != ard.pixelJobs->getJobsVector().end(); ++it) {
-    it->color = vec3(0);
-  }
+  // Workers check for cancellation every sample, so this returns within a sample's time
+  renderHandle.cancelAndWait();
 
   allFinished = false;
 }
@@ -38,6 +28,11 @@ void rt::Raytracer::onUpdate() {
   if(IsKeyPressed(KEY_SPACE))
     viewState.showProgress = !viewState.showProgress;
 
+  if (IsKeyPressed(KEY_R))
+    restartRaytracing();
+
+  CheckpointIfDue();
+
   BeginDrawing();
 
   onFinished();
@@ -47,26 +42,65 @@ void rt::Raytracer::onUpdate() {
 }
 
 void rt::Raytracer::startRaytracing() {
-  ard.exit = false;
+  // Reset job queue chunks, thread times and progress, and clear results from previous job.
+  // Reuses the existing buffers unless the traversal order changed.
+  ard.setTraversalOrder(getScene()->settings.traversalOrder);
 
-  for (auto &job : ard.pixelJobs->getJobsVector()) {
-    job.color = vec3::Zero();
-  }
+  // Tiles a restricted render skips keep the previous render's pixels, a rebuilt framebuffer (or
+  // a cancelled render) has nothing left to keep
+  bool const keepPixels = ard.allTilesFinished();
 
-  for (int t = 0; t < app->getNumThreads(); t++) {
-    ard.threads.push_back(std::make_shared<std::thread>(Ray::Trace, std::ref(ard), getScene(), t));
+  // Changes can only be composited onto a render of the whole image
+  bool const previousValid = snapshotValid && keepPixels;
+
+  pendingScene         = SceneSnapshot::Take(*getScene());
+  pendingSnapshotValid = !getScene()->settings.crop;
+  snapshotValid        = false;
+
+  auto const region = RenderRegion(pendingScene, previousValid);
+
+  ard.reset();
+
+  if (region)
+    ard.restrictTo(*region, keepPixels);
+
+  // Texture tile statistics are per render, the tiles themselves stay cached
+  TileCache::Get().resetStats();
+
+  // Only the first render after launch resumes, restarting renders from scratch
+  if (!app->resumePath.empty()) {
+    auto checkpoint = LoadCheckpoint(app->resumePath);
+    if (checkpoint && RestoreCheckpoint(*checkpoint, ard, *getScene()))
+      std::cout << "Resumed " << checkpoint->finishedTiles() << " of " << ard.totalTiles() << " tiles from "
+                << app->resumePath << '\n';
+
+    app->resumePath.clear();
   }
+
+  lastCheckpoint = std::chrono::steady_clock::now();
+  progress.restart();
+
+  // Workers are owned by the app and persist between renders, only the job is submitted here.
+  renderHandle = app->getRenderPool()->submit(
+      [&ard = ard, scene = getScene(), pool = app->getRenderPool()](int threadIndex, CancellationToken const &token) {
+        Ray::Trace(ard, scene, threadIndex, pool->nodeOf(threadIndex), token);
+      });
+}
+
+void rt::Raytracer::restartRaytracing() {
+  renderHandle.cancelAndWait();
+  allFinished = false;
+
+  startRaytracing();
 }
 
 void rt::Raytracer::BlitToBuffer() {
+  TraceScope const trace("Blit to buffer");
 
   auto *pixelData = new Color[getScene()->imageWidth * getScene()->imageHeight];
-  auto  jobs      = ard.pixelJobs->getJobsVector();
 
-  // Copy over only the color data
-  for (int i = 0; i < jobs.size(); ++i) {
-    pixelData[i] = jobs[i].color.toRaylibColor(255);
-  }
+  // Converts from the tiled float buffer to row-major 8 bit colors
+  ard.frameBuffer.toRGBA8(pixelData);
 
   // Unload old texture
   UnloadTexture(ard.raytraceRT.texture);
@@ -89,20 +123,23 @@ void rt::Raytracer::BlitToBuffer() {
 bool rt::Raytracer::onFinished() {
   ClearBackground(BLACK);
 
-  bool finished = true;
-  for (auto finishedThread : ard.finishedThreads) {
-    finished &= finishedThread;
-  }
-
-  if (finished && !allFinished) {
+  if (renderHandle.finished() && !allFinished) {
     allFinished = true;
 
-    ard.KillThreads();
-
     BlitToBuffer();
+    LogRenderStats();
+
+    if (pendingSnapshotValid && ard.allTilesFinished()) {
+      snapshotValid = true;
+      renderedScene = std::move(pendingScene);
+    }
 
     if (app->saveOnRender)
       Autosave();
+
+    // A finished checkpoint resumes into a finished render, so the image can be written again
+    if (!app->checkpointPath.empty())
+      SubmitCheckpoint(*app->getImageWriter(), ard, *getScene(), app->checkpointPath);
   }
 
   auto const fitSize = EditorUtils::FitIntoArea(ImVec2(app->editorWidth, app->editorHeight),
@@ -114,6 +151,10 @@ bool rt::Raytracer::onFinished() {
   DrawTexturePro(ard.raytraceRT.texture,
                  (Rectangle){0, 0, (float)getScene()->imageWidth, (float)getScene()->imageHeight},
                  (Rectangle){dWidth / 2, dHeight / 2, fitSize.x, fitSize.y}, (Vector2){0, 0}, 0.0f, WHITE);
+
+  if (viewState.showTileCosts)
+    DrawTileCosts((Rectangle){dWidth / 2, dHeight / 2, fitSize.x, fitSize.y});
+
   return allFinished;
 }
 
@@ -123,32 +164,60 @@ void rt::Raytracer::RenderImGui() {
 
   if (viewState.showProgress) {
     if (ImGui::Begin("Thread status", 0)) {
-      ImGui::Text("%s", "Press space to toggle this menu, escape to quit");
+      ImGui::Text("%s", "Press space to toggle this menu, R to restart the render, escape to quit");
       // ImGui::Checkbox("Incremental rendering", &ard.incRender);
 
       ImGui::Separator();
 
-      ImGui::Text("Rendering progress");
-      ImGui::SameLine();
-      ImGui::ProgressBar(float(ard.pixelJobs->getCurrentChunkStart()) / ard.pixelJobs->getJobsVector().size());
+      RenderProgressImGui();
+
+      ImGui::Text("Traversal order: %s",
+                  traversalOrderLabels[static_cast<int>(ard.frameBuffer.getTileOrder())]);
+
+      if (auto cache = CacheStats(); cache.available) {
+        ImGui::Text("Last-level cache misses: %ld of %ld references (%.1f%%)", cache.misses, cache.references,
+                    cache.references > 0 ? 100.0 * cache.misses / cache.references : 0.0);
+      } else if (allFinished) {
+        ImGui::Text("Last-level cache misses: unavailable (perf events not permitted)");
+      }
+
+      // Only relevant when the scene streams pre-tiled textures
+      if (auto tiles = TileCache::Get().stats(); tiles.hits + tiles.misses > 0) {
+        ImGui::Text("Texture tiles: %ld hits, %ld misses (%.1f%% hit rate), %ld evictions", tiles.hits, tiles.misses,
+                    100.0 * tiles.hits / (tiles.hits + tiles.misses), tiles.evictions);
+        ImGui::Text("Texture tile memory: %.1f / %.1f MiB", tiles.residentBytes / 1048576.0,
+                    tiles.budgetBytes / 1048576.0);
+      }
+
+      ImGui::Separator();
+
+      RenderCounters();
 
       ImGui::Separator();
 
       ImGui::Checkbox("Show detailed thread progress", &viewState.detailedThreadProgress);
 
       if (viewState.detailedThreadProgress) {
-        if (ImGui::BeginTable("Thread status", 3)) {
+        if (ImGui::BeginTable("Thread status", 5)) {
           ImGui::TableNextRow();
 
           for (int t = 0; t < app->getNumThreads(); t++) {
+            ThreadStats const &stats = ard.threadStats[t];
+
             // Thread labels
             ImGui::TableNextRow();
             ImGui::TableNextColumn();
-            ImGui::Text("Thread %d: ", t);
+            ImGui::Text("Thread %d (node %d): ", t, app->getRenderPool()->nodeOf(t));
             ImGui::TableNextColumn();
-            ImGui::ProgressBar(ard.threadProgress[t] / 100.0f);
+            ImGui::ProgressBar(stats.progress.load(std::memory_order_relaxed) / 100.0f);
             ImGui::TableNextColumn();
-            ImGui::Text("Time: %ld ms", ard.threadTimes[t]);
+            ImGui::Text("Time: %ld ms", stats.time.load(std::memory_order_relaxed));
+            ImGui::TableNextColumn();
+            ImGui::Text("Tiles: %d (%d stolen)", stats.tiles.load(std::memory_order_relaxed),
+                        stats.stolenTiles.load(std::memory_order_relaxed));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f samples/s", stats.counters().primaryRays * 1000.0 /
+                                              std::max(stats.time.load(std::memory_order_relaxed), 1L));
           }
 
           ImGui::EndTable();
@@ -161,23 +230,177 @@ void rt::Raytracer::RenderImGui() {
   rlImGuiEnd();
 }
 
+void rt::Raytracer::RenderProgressImGui() {
+  auto const estimate = progress.update(ard);
+
+  ImGui::Text("Rendering progress");
+  ImGui::SameLine();
+  ImGui::ProgressBar(estimate.fraction());
+
+  ImGui::Text("%d / %d tiles finished, %.2f Mrays/s", estimate.finishedTiles, estimate.totalTiles,
+              estimate.mraysPerSecond);
+
+  if (allFinished)
+    ImGui::Text("Finished in %s", RenderProgress::FormatSeconds(RenderTime() / 1000.0).c_str());
+  else if (estimate.hasEta)
+    ImGui::Text("Time left: %s (+/- %s)", RenderProgress::FormatSeconds(estimate.etaSeconds).c_str(),
+                RenderProgress::FormatSeconds(estimate.etaErrSeconds).c_str());
+  else
+    ImGui::Text("Time left: estimating...");
+
+  if (estimate.renderedTiles > 0)
+    ImGui::Text("Tile cost: %.1f ms on average, %.1f ms at most", estimate.tileCostMean, estimate.tileCostMax);
+
+  ImGui::Checkbox("Show tile costs", &viewState.showTileCosts);
+}
+
+void rt::Raytracer::DrawTileCosts(Rectangle dest) const {
+  auto const &tiles = ard.frameBuffer.getTiles();
+
+  float maxCost = 0;
+  for (int i = 0; i < ard.totalTiles(); i++) {
+    maxCost = std::max(maxCost, ard.tileCost(i));
+  }
+
+  if (maxCost <= 0)
+    return;
+
+  float const scaleX = dest.width / getScene()->imageWidth;
+  float const scaleY = dest.height / getScene()->imageHeight;
+
+  for (int i = 0; i < ard.totalTiles(); i++) {
+    float const cost = ard.tileCost(i);
+    if (cost <= 0)
+      continue;
+
+    // Tiles are in framebuffer space, whose y axis points up
+    Tile const &tile = tiles[i];
+    Rectangle   rect = {dest.x + tile.x0 * scaleX, dest.y + (getScene()->imageHeight - tile.y1) * scaleY,
+                        tile.width() * scaleX, tile.height() * scaleY};
+
+    DrawRectangleRec(rect, Fade(ColorFromHSV(240.0f * (1.0f - cost / maxCost), 0.9f, 1.0f), 0.45f));
+  }
+}
+
+rt::Raytracer::CacheTotals rt::Raytracer::CacheStats() const {
+  CacheTotals totals;
+
+  for (int t = 0; t < app->getNumThreads(); t++) {
+    ThreadStats const &stats = ard.threadStats[t];
+    if (!stats.cacheCountersAvailable.load(std::memory_order_relaxed))
+      continue;
+
+    totals.available = true;
+    totals.references += stats.cacheReferences.load(std::memory_order_relaxed);
+    totals.misses += stats.cacheMisses.load(std::memory_order_relaxed);
+  }
+
+  return totals;
+}
+
+long rt::Raytracer::RenderTime() const {
+  long renderTime = 0;
+  for (int t = 0; t < app->getNumThreads(); t++) {
+    renderTime = std::max(renderTime, ard.threadStats[t].time.load(std::memory_order_relaxed));
+  }
+
+  return renderTime;
+}
+
+void rt::Raytracer::RenderCounters() const {
+  RayCounters const totals  = ard.totalCounters();
+  double const      seconds = std::max(RenderTime(), 1L) / 1000.0;
+  double const      rays    = std::max(totals.rays(), 1L);
+
+  ImGui::Text("Rays: %ld primary, %ld secondary, %ld shadow", totals.primaryRays, totals.secondaryRays,
+              totals.shadowRays);
+  ImGui::Text("%.0f samples/s, %.2f Mrays/s, average path depth %.2f", totals.primaryRays / seconds,
+              totals.rays() / seconds / 1e6, totals.averagePathDepth());
+  ImGui::Text("Per ray: %.1f BVH nodes visited, %.1f primitive tests", totals.nodesVisited / rays,
+              totals.leafTests() / rays);
+
+  if (ImGui::TreeNode("Primitive tests")) {
+    if (ImGui::BeginTable("Primitive tests", 4)) {
+      ImGui::TableSetupColumn("Type");
+      ImGui::TableSetupColumn("Tests");
+      ImGui::TableSetupColumn("Hits");
+      ImGui::TableSetupColumn("Hit rate");
+      ImGui::TableHeadersRow();
+
+      // `other` counts containers, their children are counted on their own
+      for (int t = 1; t < RayCounters::primitiveTypes; t++) {
+        if (totals.primitiveTests[t] == 0)
+          continue;
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%s", primitiveTypeLabels[t]);
+        ImGui::TableNextColumn();
+        ImGui::Text("%ld", totals.primitiveTests[t]);
+        ImGui::TableNextColumn();
+        ImGui::Text("%ld", totals.primitiveHits[t]);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f%%", 100.0 * totals.primitiveHits[t] / totals.primitiveTests[t]);
+      }
+
+      ImGui::EndTable();
+    }
+
+    ImGui::TreePop();
+  }
+}
+
+void rt::Raytracer::LogRenderStats() const {
+  long const renderTime = RenderTime();
+
+  std::cout << "Rendered in " << renderTime << " ms with "
+            << traversalOrderLabels[static_cast<int>(ard.frameBuffer.getTileOrder())] << " traversal order";
+
+  if (auto cache = CacheStats(); cache.available)
+    std::cout << ", " << cache.misses << " last-level cache misses of " << cache.references << " references";
+
+  std::cout << std::endl;
+}
+
 void rt::Raytracer::Autosave() {
-  std::stringstream ss;
+  TraceScope const trace("Autosave");
 
-  auto t  = std::time(nullptr);
-  auto tm = *std::localtime(&t);
-  ss << "screenshots/" << std::put_time(&tm, "%d-%m-%Y %H-%M-%S") << "_" << getScene()->imageWidth << "x"
-     << getScene()->imageHeight << "_" << getScene()->settings.samplesPerPixel << "_" << getScene()->settings.maxDepth
-     << ".bmp";
+  std::string const path =
+      !app->outputPath.empty()
+          ? app->outputPath
+          : TimestampedRenderPath(getScene()->imageWidth, getScene()->imageHeight,
+                                  getScene()->settings.samplesPerPixel, getScene()->settings.maxDepth, app->outputFormat);
 
-  std::cout << "Finished render: " << ss.str() << '\n';
+  std::cout << "Finished render: " << path << '\n';
 
-  Image raytraced = LoadImageFromTexture(ard.raytraceRT.texture);
+  // Copies the float results out of the framebuffer, encoding and writing happen on the writer's thread
+  app->getImageWriter()->submit(path, app->outputFormat, Snapshot(ard.frameBuffer));
+}
 
-  // 4 components for RGBA;
-  // Couldn't get raylibs ExportImage to work with BMP. It did work with PNG however
-  stbi_write_bmp(ss.str().c_str(), raytraced.width, raytraced.height, 4, raytraced.data);
+std::optional<rt::Region> rt::Raytracer::RenderRegion(SceneSnapshot const &current, bool previousValid) const {
+  Scene const &scene  = *getScene();
+  auto         region = scene.cropRegion();
 
-  UnloadImage(raytraced);
+  // Without a complete previous frame there's nothing to composite the changes onto
+  if (!scene.settings.onlyChanges || !previousValid)
+    return region;
+
+  auto const dirty = DirtyRegion(renderedScene, current, scene);
+  if (!dirty)
+    return region;
+
+  return region ? region->intersected(*dirty) : *dirty;
 }
 
+void rt::Raytracer::CheckpointIfDue() {
+  if (app->checkpointPath.empty() || allFinished)
+    return;
+
+  auto const now = std::chrono::steady_clock::now();
+  if (now - lastCheckpoint < std::chrono::seconds(app->checkpointInterval))
+    return;
+
+  // Only copies the finished tiles here, workers keep rendering while the writer saves them
+  SubmitCheckpoint(*app->getImageWriter(), ard, *getScene(), app->checkpointPath);
+  lastCheckpoint = now;
+}
@@ -1,10 +1,15 @@
 #include "AsyncRenderData.h"
+#include "DirtyRegion.h"
 #include "IState.h"
+#include "RenderPool.h"
+#include "RenderProgress.h"
 #include "data_structures/JobQueue.h"
 
 #include <raylib.h>
 #include <rlImGui.h>
-#include <stb_image_write.h>
+
+#include <chrono>
+#include <optional>
 
 namespace rt {
   class Raytracer : public IState {
@@ -17,17 +22,64 @@ namespace rt {
 
   private:
     void startRaytracing();
+
+    // Cancels the running render and starts over in the same buffers
+    void restartRaytracing();
     void BlitToBuffer();
     bool onFinished();
     void RenderImGui();
     void Autosave();
 
+    struct CacheTotals {
+      bool available  = false;
+      long references = 0;
+      long misses     = 0;
+    };
+
+    // Sums the cache counters of all workers that could open them
+    CacheTotals CacheStats() const;
+
+    // Prints the render time, traversal order and cache counters of the finished render
+    void LogRenderStats() const;
+
+    // Longest time a worker spent rendering so far, in ms
+    long RenderTime() const;
+
+    // Totals of the workers' ray and traversal counters
+    void RenderCounters() const;
+
+    // Completed tiles, throughput and time left
+    void RenderProgressImGui();
+
+    // Tints every finished tile over the image in `dest` by how long it took, blue to red
+    void DrawTileCosts(Rectangle dest) const;
+
+    // Saves a checkpoint if they're enabled and the interval passed since the last one
+    void CheckpointIfDue();
+
+    // Part of the image the next render is limited to: the crop region, the changes since the
+    // last complete render, or both intersected. No value to render everything.
+    std::optional<Region> RenderRegion(SceneSnapshot const &current, bool previousValid) const;
+
     bool allFinished = false;
+
+    // Every pixel of the framebuffer is from a render of `renderedScene`, which unchanged objects
+    // can be kept from. Set when the render of `pendingScene` finishes without a crop, a cropped
+    // render keeps the pixels but leaves them from different scenes.
+    bool          snapshotValid        = false;
+    bool          pendingSnapshotValid = false;
+    SceneSnapshot renderedScene, pendingScene;
+
+    RenderProgress progress;
+
+    std::chrono::steady_clock::time_point lastCheckpoint;
     AsyncRenderData &ard;
+    RenderHandle renderHandle;
 
     struct ViewState {
       bool showProgress = true;
       bool detailedThreadProgress = false;
+      bool showTileCosts = false;
     } viewState;
   };
 } // namespace rt
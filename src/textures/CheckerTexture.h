@@ -38,6 +38,14 @@ namespace rt {
       return even->Value(u, v, p) * multiplier;
     }
 
+    virtual vec3 Sample(float u, float v, const vec3 &p, float footprint) const override {
+      float sines = sin(scale * p.x) * sin(scale * p.y) * sin(scale * p.z);
+      if (sines < 0)
+        return odd->Sample(u, v, p, footprint) * multiplier;
+
+      return even->Sample(u, v, p, footprint) * multiplier;
+    }
+
     virtual void OnImgui() override {
       even->OnImgui();
       odd->OnImgui();
@@ -0,0 +1,54 @@
+#pragma once
+#include "../data_structures/vec3.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Filtering shared by every mip chain representation, parameterized on how texels and levels are fetched.
+namespace rt::filtering {
+  inline vec3 Lerp(vec3 const &a, vec3 const &b, float t) { return a + (b - a) * t; }
+
+  // Bilinear lookup at (u, v) in [0, 1] of a `width` x `height` level, with v = 0 at the first row.
+  // `fetch(x, y)` is only called with in-bounds coordinates: x wraps around if `wrapX` (longitudes
+  // of lat-long images, repeating textures) and clamps to the edge otherwise, y always clamps.
+  template <typename Fetch> vec3 Bilinear(Fetch &&fetch, int width, int height, float u, float v, bool wrapX = false) {
+    // Texel centers are at half-integer coordinates
+    float const x = u * width - 0.5f;
+    float const y = v * height - 0.5f;
+
+    int const   x0 = std::floor(x), y0 = std::floor(y);
+    float const fx = x - x0, fy = y - y0;
+
+    int const xa = wrapX ? ((x0 % width) + width) % width : std::clamp(x0, 0, width - 1);
+    int const xb = wrapX ? (xa + 1) % width : std::clamp(x0 + 1, 0, width - 1);
+    int const ya = std::clamp(y0, 0, height - 1), yb = std::clamp(y0 + 1, 0, height - 1);
+
+    vec3 const top    = Lerp(fetch(xa, ya), fetch(xb, ya), fx);
+    vec3 const bottom = Lerp(fetch(xa, yb), fetch(xb, yb), fx);
+    return Lerp(top, bottom, fy);
+  }
+
+  // Blends the two levels closest to `lod` (0 is the full resolution level),
+  // `bilinear(level)` samples a single level.
+  template <typename Bilinear> vec3 Trilinear(Bilinear &&bilinear, int levelCount, float lod) {
+    lod = std::clamp(lod, 0.0f, float(levelCount - 1));
+
+    int const   fine   = std::floor(lod);
+    int const   coarse = std::min(fine + 1, levelCount - 1);
+    float const t      = lod - fine;
+
+    if (t == 0.0f || fine == coarse)
+      return bilinear(fine);
+
+    return Lerp(bilinear(fine), bilinear(coarse), t);
+  }
+
+  // Level whose bilinear filter is about `footprint` wide, `footprint` being in uv units. The
+  // filter spans two texels, so they're half of it.
+  inline float Lod(float footprint, int width, int height) {
+    if (footprint <= 0.0f)
+      return 0.0f;
+
+    return std::log2(footprint * std::max(width, height)) - 1.0f;
+  }
+} // namespace rt::filtering
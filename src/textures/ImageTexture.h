@@ -1,6 +1,7 @@
 #pragma once
 #include "../Perlin.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 #include <imgui.h>
 #include <raylib.h>
@@ -29,56 +30,64 @@ namespace rt {
       ImageFromPath(filename);
     }
 
-    ImageTexture(const json &json) { ImageFromPath(json["path"].get<std::string>().c_str()); }
+    ImageTexture(const json &json) : wrapU(json.value("wrap_u", true)) {
+      ImageFromPath(json["path"].get<std::string>().c_str());
+    }
 
     void ImageFromPath(const char *filename) {
-      int compsPerPixel = bytesPerPixel;
-      path              = filename;
+      path = filename;
+
+      // Pre-tiled images (see `--pretile`) are streamed tile by tile instead of decoded up front
+      if (path.ends_with(".rtt")) {
+        tiledImage = TextureCache::LoadTiled(path);
+        img        = Image{};
+        if (tiledImage) {
+          img.width  = tiledImage->width();
+          img.height = tiledImage->height();
+        }
+        return;
+      }
 
-      img = LoadImage(filename);
-      if (img.data == nullptr) {
-        std::cerr << "ERROR: could not load texture image file " << filename << ".\n";
+      // Textures sharing an image file share one decoded copy, which is freed with the last of them
+      cachedImage = TextureCache::Load(path, PIXELFORMAT_UNCOMPRESSED_R8G8B8);
+      if (cachedImage) {
+        img = cachedImage->image;
+      } else {
+        img       = Image{};
         img.width = img.height = 0;
       }
-
-      bytesPerScanline = bytesPerPixel * img.width;
     }
 
-    ~ImageTexture() {
-      // Causes a segfault
-      /*UnloadImage(img);*/
-    }
+    virtual vec3 Value(float u, float v, const vec3 &p) const override { return Sample(u, v, p, 0.0f); }
 
-    virtual vec3 Value(float u, float v, const vec3 &p) const override {
+    // Trilinear lookup in the image's mip chain, picking levels whose texels match the footprint
+    virtual vec3 Sample(float u, float v, const vec3 &p, float footprint) const override {
       // If we have no texture data, then return solid cyan as a debugging aid.
-      if (img.data == nullptr)
+      if (!tiledImage && (!cachedImage || cachedImage->mips.empty()))
         return vec3(0, 1, 1);
 
       // Clamp input texture coordinates to [0,1] x [1,0]
+      u = Clamp(u, 0.0, 1.0);
+      v = Clamp(v, 0.0, 1.0);
 
       if (flipV)
-        v = 1.0f - Clamp(v, 0.0, 1.0);
+        v = 1.0f - v;
 
       if (flipH)
-        u = 1.0f - Clamp(u, 0.0, 1.0);
-
-      int i = u * img.width;
-      int j = v * img.height;
-
-      // Clamp integer mapping since actual coords should be < 1.0
-      if (i >= img.width)
-        i = img.width - 1;
-      if (j >= img.height)
-        j = img.height - 1;
+        u = 1.0f - u;
 
       // Since we read 8 bit integer values for r, g, and b.
       // Need to convert them to [0,1.0]
-      const float    colorScale = 1.0 / 255.0;
-      unsigned char *pixel      = (unsigned char *)img.data + j * bytesPerScanline + i * bytesPerPixel;
-      return vec3(pixel[0], pixel[1], pixel[2]) * colorScale * multiplier;
+      const float colorScale = 1.0 / 255.0;
+
+      if (tiledImage)
+        return tiledImage->Trilinear(u, v, tiledImage->Lod(footprint), wrapU) * colorScale * multiplier;
+
+      MipPyramid const &mips = cachedImage->mips;
+      return mips.Trilinear(u, v, mips.Lod(footprint), wrapU) * colorScale * multiplier;
     }
 
-    virtual json toJson() const override { return json{{"type", "image"}, {"path", path}}; }
+    virtual json toJson() const override { return json{{"type", "image"}, {"path", path}, {"wrap_u", wrapU}}; }
 
     ::Texture generatePreview(int availableWidth, int availableHeight, float scale) override {
       return Texture::SamplePreview(
@@ -92,11 +101,15 @@ namespace rt {
     }
 
   private:
-    int              bytesPerScanline;
-    std::string      path;
-    Image            img;
-    bool             flipH = false, flipV = false;
-    const static int bytesPerPixel = 3;
+    std::string             path;
+    Image                   img; // Size of the image, the pixels are in `cachedImage`'s mip chain
+    sPtr<const CachedImage> cachedImage;
+    sPtr<TiledImage>        tiledImage; // Set instead of `cachedImage` for pre-tiled images
+    bool                    flipH = false, flipV = false;
+
+    // Filter across the left and right edges, for lat-long images on spheres (the usual case) and
+    // repeating images. Off for images that end at their edges.
+    bool wrapU = true;
   };
 
   inline void to_json(json &j, const ImageTexture &it) { j = it.toJson(); }
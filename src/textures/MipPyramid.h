@@ -0,0 +1,126 @@
+#pragma once
+#include "../data_structures/vec3.h"
+#include "Filtering.h"
+#include "TexelLayout.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace rt {
+  // Four bytes so a texel is a single aligned load
+  struct alignas(4) Texel8 {
+    unsigned char r, g, b, a;
+  };
+
+  // Texels of a level or tile, cache line aligned so 4x4 blocks don't straddle two lines
+  using TexelBuffer = std::vector<Texel8, AlignedAllocator<Texel8, 64>>;
+
+  /**
+   * @brief Box-filtered mip chain of an RGB8 image, with bilinear and trilinear lookups.
+   *
+   * Every level, the full resolution one included, is repacked into RGBA8 texels laid out by
+   * `Layout`, and halves the previous one down to 1x1.
+   */
+  template <typename Layout> class BasicMipPyramid {
+  public:
+    struct Level {
+      int                 width, height;
+      int                 paddedWidth; // Rounded up to whole blocks
+      TexelBuffer         texels;
+
+      Texel8 const &At(int x, int y) const { return texels[Layout::Index(x, y, paddedWidth)]; }
+      Texel8       &At(int x, int y) { return texels[Layout::Index(x, y, paddedWidth)]; }
+    };
+
+    BasicMipPyramid() = default;
+
+    explicit BasicMipPyramid(Image const &image) {
+      if (image.data == nullptr || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8)
+        return;
+
+      Level &base = AddLevel(image.width, image.height);
+
+      auto const *rgb = (const unsigned char *)image.data;
+      for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+          const unsigned char *pixel = rgb + (std::size_t(y) * image.width + x) * 3;
+          base.At(x, y)              = {pixel[0], pixel[1], pixel[2], 255};
+        }
+      }
+
+      while (levels.back().width > 1 || levels.back().height > 1) {
+        int const w = std::max(1, levels.back().width / 2);
+        int const h = std::max(1, levels.back().height / 2);
+
+        Level       &dst = AddLevel(w, h);
+        Level const &src = levels[levels.size() - 2];
+
+        for (int y = 0; y < h; y++) {
+          for (int x = 0; x < w; x++) {
+            // Odd edges drop their last row/column, 1 texel wide levels average with themselves
+            int const x0 = std::min(2 * x, src.width - 1), x1 = std::min(2 * x + 1, src.width - 1);
+            int const y0 = std::min(2 * y, src.height - 1), y1 = std::min(2 * y + 1, src.height - 1);
+
+            Texel8 const &a = src.At(x0, y0), &b = src.At(x1, y0), &c = src.At(x0, y1), &d = src.At(x1, y1);
+
+            dst.At(x, y) = {(unsigned char)((a.r + b.r + c.r + d.r + 2) / 4),
+                            (unsigned char)((a.g + b.g + c.g + d.g + 2) / 4),
+                            (unsigned char)((a.b + b.b + c.b + d.b + 2) / 4), 255};
+          }
+        }
+      }
+    }
+
+    bool empty() const { return levels.empty(); }
+    int  levelCount() const { return levels.size(); }
+
+    std::size_t bytes() const {
+      std::size_t total = 0;
+      for (auto const &l : levels) {
+        total += l.texels.size() * sizeof(Texel8);
+      }
+
+      return total;
+    }
+
+    Level const &level(int i) const { return levels[i]; }
+
+    // Bilinearly filtered color of `level` at (u, v), both in [0, 1] with v = 0 at the first row.
+    // Wraps around horizontally if `wrapU`, clamps otherwise.
+    vec3 Bilinear(int levelIndex, float u, float v, bool wrapU = false) const {
+      Level const &l = levels[levelIndex];
+
+      return filtering::Bilinear(
+          [&l](int x, int y) {
+            Texel8 const &texel = l.At(x, y);
+            return vec3(texel.r, texel.g, texel.b);
+          },
+          l.width, l.height, u, v, wrapU);
+    }
+
+    // Blends the two levels closest to `lod` (0 is the full resolution level)
+    vec3 Trilinear(float u, float v, float lod, bool wrapU = false) const {
+      return filtering::Trilinear([&](int level) { return Bilinear(level, u, v, wrapU); }, levels.size(), lod);
+    }
+
+    // Level whose texels are about `footprint` wide, `footprint` being in uv units
+    float Lod(float footprint) const {
+      return levels.empty() ? 0.0f : filtering::Lod(footprint, levels[0].width, levels[0].height);
+    }
+
+  private:
+    Level &AddLevel(int width, int height) {
+      int const n       = Layout::blockSize;
+      int const paddedW = (width + n - 1) / n * n;
+      int const paddedH = (height + n - 1) / n * n;
+
+      return levels.emplace_back(Level{width, height, paddedW, TexelBuffer(std::size_t(paddedW) * paddedH)});
+    }
+
+    std::vector<Level> levels;
+  };
+
+  using MipPyramid = BasicMipPyramid<BlockLayout<4>>;
+} // namespace rt
@@ -1,6 +1,7 @@
 #pragma once
 #include "../Perlin.h"
 #include "../data_structures/vec3.h"
+#include "NoiseVolume.h"
 #include "Texture.h"
 
 #include <imgui.h>
@@ -18,19 +19,41 @@ namespace rt {
         : noise(std::make_shared<Perlin>()), scale(scl), turbScale(tScl), baseColor(baseCol) {}
 
     NoiseTexture(const json &json)
-        : scale(json["scale"].get<float>()), turbScale(json["turb_scale"].get<float>()),
-          baseColor(json["base_color"].get<vec3>()) {}
+        : noise(std::make_shared<Perlin>()), scale(json["scale"].get<float>()),
+          turbScale(json["turb_scale"].get<float>()), baseColor(json["base_color"].get<vec3>()) {
+      // Optional, bakes the turbulence over the given bounds
+      if (json.contains("bake")) {
+        auto const &bake = json["bake"];
+        bakeMin          = bake["min"].get<vec3>();
+        bakeMax          = bake["max"].get<vec3>();
+        bakeResolution   = bake["resolution"].get<int>();
+        Bake();
+      }
+    }
 
     virtual vec3 Value(float u, float v, const vec3 &p) const override {
+      // Points outside the baked volume (if any) fall back to evaluating the noise
+      float turb = volume && volume->Contains(p) ? volume->Turb(p) : noise->Turb(p);
+
       // The noise fn can return negative values
       // Scale it to between 0 and 1
-      return (vec3(1, 1, 1) * 0.5 * (1.0 + sin(scale * (p.z) + turbScale * noise->Turb(p))) * baseColor) * multiplier;
+      return (vec3(1, 1, 1) * 0.5 * (1.0 + sin(scale * (p.z) + turbScale * turb)) * baseColor) * multiplier;
     }
 
     virtual json toJson() const override {
-      return json{{"type", "noise"}, {"scale", scale}, {"turb_scale", turbScale}, {"base_color", baseColor}};
+      json j = {{"type", "noise"}, {"scale", scale}, {"turb_scale", turbScale}, {"base_color", baseColor}};
+      if (volume)
+        j["bake"] = {{"min", bakeMin}, {"max", bakeMax}, {"resolution", bakeResolution}};
+
+      return j;
     }
 
+    // Precomputes the turbulence over [bakeMin, bakeMax] at `bakeResolution`^3 points.
+    // Must not be called while a render is using this texture.
+    void Bake() { volume = std::make_shared<const NoiseVolume>(*noise, bakeMin, bakeMax, bakeResolution); }
+
+    void DiscardBake() { volume = nullptr; }
+
 
     // TODO: Better perlin preview
     // Main issue: result depends on the given point and not the uv coords
@@ -48,6 +71,19 @@ namespace rt {
       ImGui::DragFloat("Turbulance scale", &turbScale, 0.1f);
       ImGui::ColorEdit3("Base color", &baseColor.x);
 
+      bool baked = volume != nullptr;
+      if (ImGui::Checkbox("Bake noise volume", &baked))
+        baked ? Bake() : DiscardBake();
+
+      if (baked) {
+        ImGui::DragFloat3("Bake bounds min", &bakeMin.x, 0.1f);
+        ImGui::DragFloat3("Bake bounds max", &bakeMax.x, 0.1f);
+        ImGui::DragInt("Bake resolution", &bakeResolution, 1, 2, 512);
+
+        if (ImGui::Button("Rebake"))
+          Bake();
+      }
+
       ImGui::Spacing();
 
       Texture::OnImgui();
@@ -58,6 +94,11 @@ namespace rt {
     float        scale;
     float        turbScale;
     vec3         baseColor;
+
+    sPtr<const NoiseVolume> volume; // Null unless baked
+    vec3                    bakeMin        = vec3(-1);
+    vec3                    bakeMax        = vec3(1);
+    int                     bakeResolution = 128;
   };
 
   inline void to_json(json &j, const NoiseTexture &nt) { j = json{{"type", "noise"}, nt.toJson()}; }
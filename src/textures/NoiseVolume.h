@@ -0,0 +1,85 @@
+#pragma once
+#include "../Perlin.h"
+#include "../data_structures/vec3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace rt {
+  /**
+   * @brief Perlin turbulence baked on a regular grid over a box, read back with trilinear
+   * interpolation.
+   *
+   * Replaces 7 octaves of noise with 8 loads for static noise textures. Detail finer than the
+   * grid spacing is lost, so the resolution has to match the highest octave that matters.
+   */
+  class NoiseVolume {
+  public:
+    // Flat bounds (of rects and planes) are thickened by a small extent, so lookups never divide
+    // by zero
+    NoiseVolume(Perlin const &noise, vec3 min, vec3 max, int resolution, int depth = 7)
+        : min(min), max(Thickened(min, max)), resolution(std::max(resolution, 2)),
+          samples(std::size_t(this->resolution) * this->resolution * this->resolution) {
+
+      vec3 const step = (this->max - min) / float(this->resolution - 1);
+      int const  n    = this->resolution;
+
+#pragma omp parallel for
+      for (int z = 0; z < n; z++) {
+        for (int y = 0; y < n; y++) {
+          for (int x = 0; x < n; x++) {
+            samples[Index(x, y, z)] = noise.Turb(min + vec3(x, y, z) * step, depth);
+          }
+        }
+      }
+    }
+
+    bool Contains(const vec3 &p) const {
+      return p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z;
+    }
+
+    // Turbulence at `p`, which has to be inside the volume
+    float Turb(const vec3 &p) const {
+      int const last = resolution - 1;
+
+      float const fx = (p.x - min.x) / (max.x - min.x) * last;
+      float const fy = (p.y - min.y) / (max.y - min.y) * last;
+      float const fz = (p.z - min.z) / (max.z - min.z) * last;
+
+      int const x0 = std::clamp(int(fx), 0, last - 1);
+      int const y0 = std::clamp(int(fy), 0, last - 1);
+      int const z0 = std::clamp(int(fz), 0, last - 1);
+
+      float const tx = fx - x0, ty = fy - y0, tz = fz - z0;
+
+      auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+
+      float const c00 = lerp(samples[Index(x0, y0, z0)], samples[Index(x0 + 1, y0, z0)], tx);
+      float const c10 = lerp(samples[Index(x0, y0 + 1, z0)], samples[Index(x0 + 1, y0 + 1, z0)], tx);
+      float const c01 = lerp(samples[Index(x0, y0, z0 + 1)], samples[Index(x0 + 1, y0, z0 + 1)], tx);
+      float const c11 = lerp(samples[Index(x0, y0 + 1, z0 + 1)], samples[Index(x0 + 1, y0 + 1, z0 + 1)], tx);
+
+      return lerp(lerp(c00, c10, ty), lerp(c01, c11, ty), tz);
+    }
+
+    vec3 getMin() const { return min; }
+    vec3 getMax() const { return max; }
+    int  getResolution() const { return resolution; }
+
+  private:
+    static constexpr float minExtent = 1e-4f;
+
+    // Relative to the coordinates too, far from the origin 1e-4 would round away
+    static vec3 Thickened(vec3 const &min, vec3 const &max) {
+      auto const thicken = [](float lo, float hi) { return std::max(hi, lo + std::max(minExtent, std::abs(lo) * 1e-5f)); };
+      return vec3(thicken(min.x, max.x), thicken(min.y, max.y), thicken(min.z, max.z));
+    }
+
+    std::size_t Index(int x, int y, int z) const { return (std::size_t(z) * resolution + y) * resolution + x; }
+
+    vec3               min, max;
+    int                resolution;
+    std::vector<float> samples;
+  };
+} // namespace rt
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace rt {
+  // Texel layouts map a texel's (x, y) to its position in a level's storage. Levels are padded
+  // to whole blocks, `paddedWidth` is the padded width in texels.
+
+  // Plain scanlines, vertical neighbours are a whole row apart
+  struct RowMajorLayout {
+    static constexpr int blockSize = 1;
+
+    static std::size_t Index(int x, int y, int paddedWidth) { return std::size_t(y) * paddedWidth + x; }
+  };
+
+  // Square `N` x `N` blocks stored one after the other, texels row-major inside a block.
+  // 4x4 RGBA8 texels fill exactly one 64 byte cache line (in storage allocated with
+  // `AlignedAllocator<..., 64>`), so a bilinear footprint usually touches a single line instead
+  // of two rows of the image.
+  template <int N> struct BlockLayout {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Block size has to be a power of two");
+
+    static constexpr int blockSize = N;
+
+    // Coordinates are never negative, unsigned math turns the divisions and modulos into shifts and masks
+    static std::size_t Index(int x, int y, int paddedWidth) {
+      unsigned const ux = x, uy = y, blocksX = unsigned(paddedWidth) / N;
+      return (std::size_t(uy / N) * blocksX + ux / N) * (N * N) + (uy % N) * N + (ux % N);
+    }
+  };
+
+  // Allocator for containers whose storage has to start on an `Alignment` byte boundary
+  template <typename T, std::size_t Alignment> struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U> struct rebind {
+      using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(AlignedAllocator<U, Alignment> const &) {}
+
+    T   *allocate(std::size_t n) { return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+    void deallocate(T *p, std::size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    friend bool operator==(AlignedAllocator const &, AlignedAllocator const &) { return true; }
+  };
+} // namespace rt
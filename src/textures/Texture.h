@@ -25,6 +25,10 @@ namespace rt {
     }
 
     virtual vec3 Value(float u, float v, const vec3 &p) const = 0;
+
+    // Value averaged over a footprint `footprint` uv units wide. Textures that can't prefilter
+    // fall back to point sampling.
+    virtual vec3 Sample(float u, float v, const vec3 &p, float footprint) const { return Value(u, v, p); }
     virtual json toJson() const                               = 0;
     virtual void setIntensity(float i) { multiplier = i; }
 
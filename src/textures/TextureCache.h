@@ -0,0 +1,119 @@
+#pragma once
+#include "../Defs.h"
+#include "../TraceEvents.h"
+#include "MipPyramid.h"
+#include "TiledImage.h"
+
+#include <raylib.h>
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace rt {
+  /**
+   * @brief Decoded image owned by the texture cache, along with its mip chain. Immutable once
+   * loaded, so it can be shared between any number of textures and read from any thread.
+   */
+  struct CachedImage {
+    Image      image; // Pixels freed (null) once the mip chain holds them, size and format kept
+    MipPyramid mips;  // Empty unless the image is RGB8
+
+    explicit CachedImage(Image image) : image(image), mips(this->image) {
+      if (!mips.empty()) {
+        UnloadImage(this->image);
+        this->image.data = nullptr;
+      }
+    }
+    ~CachedImage() { UnloadImage(image); }
+
+    std::size_t bytes() const {
+      std::size_t const pixels = image.data ? GetPixelDataSize(image.width, image.height, image.format) : 0;
+      return pixels + mips.bytes();
+    }
+
+    CachedImage(CachedImage const &)            = delete;
+    CachedImage &operator=(CachedImage const &) = delete;
+  };
+
+  /**
+   * @brief Process-wide cache of decoded images, keyed by path and pixel format, and of opened
+   * tiled images, keyed by path.
+   *
+   * Only weak references are kept, so an image is freed as soon as the last texture using it is
+   * destroyed, and decoded again if it's needed after that.
+   */
+  class TextureCache {
+  public:
+    // Returns the image at `path` converted to `format`, decoding it only if it isn't already
+    // loaded. Returns nullptr if the image can't be loaded.
+    static sPtr<const CachedImage> Load(std::string const &path, PixelFormat format) {
+      std::lock_guard<std::mutex> lk{cacheMutex};
+
+      auto &entry = entries[{path, format}];
+      if (auto cached = entry.lock())
+        return cached;
+
+      TraceScope const trace("Decode texture");
+
+      Image image = LoadImage(path.c_str());
+      if (image.data == nullptr) {
+        std::cerr << "ERROR: could not load texture image file " << path << ".\n";
+        entries.erase({path, format});
+        return nullptr;
+      }
+
+      if (image.format != format)
+        ImageFormat(&image, format);
+
+      auto loaded = std::make_shared<const CachedImage>(image);
+      entry       = loaded;
+
+      pruneExpired();
+      return loaded;
+    }
+
+    // Returns the tiled image at `path`, sharing it (and so its cached tiles) between every
+    // texture using it. Returns nullptr if the file isn't a tiled image.
+    static sPtr<TiledImage> LoadTiled(std::string const &path) {
+      std::lock_guard<std::mutex> lk{cacheMutex};
+
+      auto &entry = tiledEntries[path];
+      if (auto cached = entry.lock())
+        return cached;
+
+      auto opened = TiledImage::Open(path);
+      entry       = opened;
+
+      std::erase_if(tiledEntries, [](auto const &entry) { return entry.second.expired(); });
+      return opened;
+    }
+
+    // Memory held by the decoded images still in use, tiled images are accounted for by the `TileCache`
+    static std::size_t ResidentBytes() {
+      std::lock_guard<std::mutex> lk{cacheMutex};
+
+      std::size_t bytes = 0;
+      for (auto const &[key, entry] : entries) {
+        if (auto cached = entry.lock())
+          bytes += cached->bytes();
+      }
+
+      return bytes;
+    }
+
+  private:
+    using Key = std::pair<std::string, int>;
+
+    // Drops entries whose images were already freed
+    static void pruneExpired() {
+      std::erase_if(entries, [](auto const &entry) { return entry.second.expired(); });
+    }
+
+    inline static std::mutex                                        cacheMutex;
+    inline static std::map<Key, std::weak_ptr<const CachedImage>>   entries;
+    inline static std::map<std::string, std::weak_ptr<TiledImage>> tiledEntries;
+  };
+} // namespace rt
@@ -0,0 +1,91 @@
+#include "TileCache.h"
+
+namespace rt {
+  TileCache &TileCache::Get() {
+    static TileCache cache;
+    return cache;
+  }
+
+  void TileCache::setBudget(std::size_t bytes) {
+    budgetBytes.store(bytes, std::memory_order_relaxed);
+
+    for (auto &shard : shards) {
+      std::lock_guard<std::mutex> lk{shard.shardMutex};
+      evict(shard, bytes / shardCount);
+    }
+  }
+
+  sPtr<const TextureTile> TileCache::Acquire(Key key, Loader const &load) {
+    // Keys pack tile coordinates in their low bits, mix them so neighbouring tiles land in different shards
+    Shard &shard = shards[(key * 0x9E3779B97F4A7C15ull) >> 60];
+
+    std::unique_lock<std::mutex> lk{shard.shardMutex};
+
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      shard.hits.fetch_add(1, std::memory_order_relaxed);
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      return it->second->second;
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+
+    // Reads can be slow, don't hold up lookups of the shard's other tiles meanwhile
+    lk.unlock();
+    auto tile = load();
+    lk.lock();
+
+    if (!tile)
+      return nullptr;
+
+    // Another worker missed the same tile and loaded it first, share its copy
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      return it->second->second;
+    }
+
+    shard.lru.emplace_front(key, tile);
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += tile->texels.size() * sizeof(Texel8);
+
+    evict(shard, getBudget() / shardCount);
+
+    return tile;
+  }
+
+  void TileCache::evict(Shard &shard, std::size_t shardBudget) {
+    // Always keep the most recent tile, even if it alone is over budget
+    while (shard.bytes > shardBudget && shard.lru.size() > 1) {
+      auto const &[key, tile] = shard.lru.back();
+
+      shard.bytes -= tile->texels.size() * sizeof(Texel8);
+      shard.index.erase(key);
+      shard.lru.pop_back();
+
+      shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  TileCache::Stats TileCache::stats() const {
+    Stats stats;
+    stats.budgetBytes = getBudget();
+
+    for (auto const &shard : shards) {
+      stats.hits += shard.hits.load(std::memory_order_relaxed);
+      stats.misses += shard.misses.load(std::memory_order_relaxed);
+      stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+
+      std::lock_guard<std::mutex> lk{shard.shardMutex};
+      stats.residentBytes += shard.bytes;
+    }
+
+    return stats;
+  }
+
+  void TileCache::resetStats() {
+    for (auto &shard : shards) {
+      shard.hits.store(0, std::memory_order_relaxed);
+      shard.misses.store(0, std::memory_order_relaxed);
+      shard.evictions.store(0, std::memory_order_relaxed);
+    }
+  }
+} // namespace rt
@@ -0,0 +1,75 @@
+#pragma once
+#include "../Defs.h"
+#include "MipPyramid.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rt {
+  // Square block of texels of one mip level of a tiled image, immutable once loaded
+  struct TextureTile {
+    TexelBuffer texels;
+  };
+
+  /**
+   * @brief Process-wide cache of texture tiles streamed from disk, bounded by a memory budget.
+   *
+   * Split into shards, each with its own lock, LRU list and share of the budget, so workers
+   * sampling different tiles rarely contend. Tiles are handed out as shared pointers, evicting a
+   * tile a worker is still reading only drops the cache's reference to it.
+   */
+  class TileCache {
+  public:
+    using Key    = std::uint64_t;
+    using Loader = std::function<sPtr<const TextureTile>()>;
+
+    struct Stats {
+      long        hits = 0, misses = 0, evictions = 0;
+      std::size_t residentBytes = 0, budgetBytes = 0;
+    };
+
+    static TileCache &Get();
+
+    void        setBudget(std::size_t bytes);
+    std::size_t getBudget() const { return budgetBytes.load(std::memory_order_relaxed); }
+
+    // Returns the tile for `key`, calling `load` (without holding the shard's lock) if it isn't
+    // resident. Workers missing the same tile at once may each load it, the first copy is kept.
+    // Returns nullptr if loading failed.
+    sPtr<const TextureTile> Acquire(Key key, Loader const &load);
+
+    Stats stats() const;
+
+    // Clears hit, miss and eviction counts, resident tiles stay
+    void resetStats();
+
+  private:
+    TileCache() = default;
+
+    static constexpr int shardCount = 16;
+
+    struct Shard {
+      using Entry = std::pair<Key, sPtr<const TextureTile>>;
+
+      mutable std::mutex                                  shardMutex;
+      std::list<Entry>                                    lru; // Most recently used first
+      std::unordered_map<Key, std::list<Entry>::iterator> index;
+      std::size_t                                         bytes = 0;
+
+      std::atomic<long> hits{0}, misses{0}, evictions{0};
+    };
+
+    void evict(Shard &shard, std::size_t shardBudget);
+
+    std::array<Shard, shardCount> shards;
+    std::atomic<std::size_t>      budgetBytes{std::size_t(512) << 20};
+  };
+} // namespace rt
@@ -0,0 +1,222 @@
+#include "TiledImage.h"
+#include "Filtering.h"
+#include "MipPyramid.h"
+#include "TexelLayout.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+  const char          magic[4] = {'R', 'T', 'T', 'X'};
+  const std::uint32_t version  = 1;
+
+  // Tiles are stored in 4x4 blocks, like in-memory mip levels
+  using TileLayout = rt::BlockLayout<4>;
+
+  // Bounds on header values, well past what `Write` produces. A 32 bit wide level halves to
+  // 1x1 in 33 levels.
+  const std::uint32_t maxTileSize   = 4096;
+  const std::uint32_t maxLevelCount = 33;
+  const std::uint32_t maxDimension  = std::numeric_limits<int>::max();
+
+  // Cache keys: 20 bits of image id, then the tile's index across all levels of the image
+  std::uint64_t TileKey(std::uint32_t imageId, std::uint64_t tileIndex) {
+    return (std::uint64_t(imageId) << 44) | tileIndex;
+  }
+
+  // Last tile each worker sampled. Consecutive lookups mostly land in the same tile, this skips
+  // the shared cache (and its lock) for them.
+  struct LastTile {
+    std::uint64_t                   key = ~std::uint64_t(0);
+    sPtr<const rt::TextureTile>     tile;
+  };
+
+  thread_local LastTile lastTile;
+} // namespace
+
+namespace rt {
+  sPtr<TiledImage> TiledImage::Open(std::string const &path) {
+    static std::atomic<std::uint32_t> nextId{0};
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      std::cerr << "ERROR: could not open tiled image " << path << ".\n";
+      return nullptr;
+    }
+
+    sPtr<TiledImage> image(new TiledImage());
+    image->fd = fd;
+
+    char          fileMagic[4];
+    std::uint32_t header[3];
+    if (pread(fd, fileMagic, sizeof(fileMagic), 0) != sizeof(fileMagic) || std::memcmp(fileMagic, magic, 4) != 0 ||
+        pread(fd, header, sizeof(header), sizeof(fileMagic)) != sizeof(header) || header[0] != version ||
+        header[1] == 0 || header[2] == 0) {
+      std::cerr << "ERROR: " << path << " is not a tiled image.\n";
+      return nullptr;
+    }
+
+    if (header[1] > maxTileSize || header[1] % TileLayout::blockSize != 0 || header[2] > maxLevelCount) {
+      std::cerr << "ERROR: " << path << " has an invalid tile size or level count.\n";
+      return nullptr;
+    }
+
+    image->tileSize = header[1];
+    image->levels.resize(header[2]);
+
+    std::uint64_t const levelsOffset = sizeof(fileMagic) + sizeof(header);
+    std::size_t const   levelsSize   = image->levels.size() * sizeof(Level);
+    if (pread(fd, image->levels.data(), levelsSize, levelsOffset) != (ssize_t)levelsSize) {
+      std::cerr << "ERROR: " << path << " is truncated.\n";
+      return nullptr;
+    }
+
+    image->dataOffset = levelsOffset + levelsSize;
+
+    // Levels have to be the chain `Write` produces, with their tiles inside the file, lookups
+    // index them without checks
+    std::uint64_t tileCount = 0;
+    for (std::size_t l = 0; l < image->levels.size(); l++) {
+      Level const  &level   = image->levels[l];
+      std::uint32_t tileDim = image->tileSize;
+
+      bool const sizeValid = l == 0 ? level.width > 0 && level.height > 0 && level.width <= maxDimension &&
+                                          level.height <= maxDimension
+                                    : level.width == std::max(1u, image->levels[l - 1].width / 2) &&
+                                          level.height == std::max(1u, image->levels[l - 1].height / 2);
+
+      if (!sizeValid || level.tilesX != (level.width + tileDim - 1) / tileDim ||
+          level.tilesY != (level.height + tileDim - 1) / tileDim || level.firstTile != tileCount) {
+        std::cerr << "ERROR: " << path << " has an invalid mip level " << l << ".\n";
+        return nullptr;
+      }
+
+      tileCount += std::uint64_t(level.tilesX) * level.tilesY;
+    }
+
+    struct stat fileStat;
+    std::uint64_t const tileBytes = std::uint64_t(image->tileSize) * image->tileSize * sizeof(Texel8);
+    if (fstat(fd, &fileStat) != 0 || tileCount >= (std::uint64_t(1) << 44) ||
+        image->dataOffset + tileCount * tileBytes > std::uint64_t(fileStat.st_size)) {
+      std::cerr << "ERROR: " << path << " is truncated.\n";
+      return nullptr;
+    }
+
+    image->id         = nextId.fetch_add(1, std::memory_order_relaxed) & 0xFFFFF;
+
+    return image;
+  }
+
+  bool TiledImage::Write(Image const &image, std::string const &path, int tileSize) {
+    MipPyramid mips(image);
+    if (mips.empty()) {
+      std::cerr << "ERROR: tiled images can only be written from RGB8 images.\n";
+      return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "ERROR: could not open " << path << " for writing.\n";
+      return false;
+    }
+
+    std::uint32_t const header[3] = {version, std::uint32_t(tileSize), std::uint32_t(mips.levelCount())};
+    file.write(magic, sizeof(magic));
+    file.write((const char *)header, sizeof(header));
+
+    std::vector<Level> levels;
+    std::uint32_t      firstTile = 0;
+    for (int l = 0; l < mips.levelCount(); l++) {
+      auto const   &level = mips.level(l);
+      std::uint32_t tx = (level.width + tileSize - 1) / tileSize, ty = (level.height + tileSize - 1) / tileSize;
+
+      levels.push_back({std::uint32_t(level.width), std::uint32_t(level.height), tx, ty, firstTile});
+      firstTile += tx * ty;
+    }
+    file.write((const char *)levels.data(), levels.size() * sizeof(Level));
+
+    std::vector<Texel8> tile(tileSize * tileSize);
+    for (int l = 0; l < mips.levelCount(); l++) {
+      auto const &level = mips.level(l);
+
+      for (std::uint32_t ty = 0; ty < levels[l].tilesY; ty++) {
+        for (std::uint32_t tx = 0; tx < levels[l].tilesX; tx++) {
+          for (int y = 0; y < tileSize; y++) {
+            for (int x = 0; x < tileSize; x++) {
+              // Pad edge tiles by repeating the last row/column
+              int const sx = std::min<int>(tx * tileSize + x, level.width - 1);
+              int const sy = std::min<int>(ty * tileSize + y, level.height - 1);
+
+              tile[TileLayout::Index(x, y, tileSize)] = level.At(sx, sy);
+            }
+          }
+
+          file.write((const char *)tile.data(), tile.size() * sizeof(Texel8));
+        }
+      }
+    }
+
+    return bool(file);
+  }
+
+  TiledImage::~TiledImage() {
+    if (fd != -1)
+      close(fd);
+  }
+
+  sPtr<const TextureTile> TiledImage::LoadTile(std::uint64_t tileIndex) const {
+    auto tile = std::make_shared<TextureTile>();
+    tile->texels.resize(tileSize * tileSize);
+
+    std::size_t const   tileBytes = tile->texels.size() * sizeof(Texel8);
+    std::uint64_t const offset    = dataOffset + tileIndex * tileBytes;
+
+    // pread doesn't move a shared file position, so workers can read concurrently
+    if (pread(fd, tile->texels.data(), tileBytes, offset) != (ssize_t)tileBytes) {
+      std::cerr << "ERROR: could not read texture tile " << tileIndex << ".\n";
+      return nullptr;
+    }
+
+    return tile;
+  }
+
+  Texel8 TiledImage::Fetch(int level, int x, int y) const {
+
+    Level const        &l         = levels[level];
+    std::uint64_t const tileIndex = l.firstTile + std::uint64_t(y / tileSize) * l.tilesX + x / tileSize;
+    std::uint64_t const key       = TileKey(id, tileIndex);
+
+    if (lastTile.key != key) {
+      lastTile.tile = TileCache::Get().Acquire(key, [&] { return LoadTile(tileIndex); });
+      lastTile.key  = key;
+    }
+
+    if (!lastTile.tile)
+      return {0, 255, 255, 255}; // Same cyan as textures without data
+
+    return lastTile.tile->texels[TileLayout::Index(x % tileSize, y % tileSize, tileSize)];
+  }
+
+  vec3 TiledImage::Bilinear(int level, float u, float v, bool wrapU) const {
+    return filtering::Bilinear(
+        [&](int x, int y) {
+          Texel8 const texel = Fetch(level, x, y);
+          return vec3(texel.r, texel.g, texel.b);
+        },
+        levels[level].width, levels[level].height, u, v, wrapU);
+  }
+
+  vec3 TiledImage::Trilinear(float u, float v, float lod, bool wrapU) const {
+    return filtering::Trilinear([&](int level) { return Bilinear(level, u, v, wrapU); }, levels.size(), lod);
+  }
+
+  float TiledImage::Lod(float footprint) const { return filtering::Lod(footprint, width(), height()); }
+} // namespace rt
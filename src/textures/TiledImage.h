@@ -0,0 +1,66 @@
+#pragma once
+#include "../Defs.h"
+#include "../data_structures/vec3.h"
+#include "TileCache.h"
+
+#include <raylib.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rt {
+  /**
+   * @brief Mip-mapped image stored on disk in fixed size tiles, streamed through the TileCache.
+   *
+   * Only the header is read when opening, tiles are read the first time they're sampled and
+   * evicted when the cache runs over budget.
+   *
+   * File layout (`.rtt`, native endianness):
+   *   header   "RTTX", version, tile size, level count (4 x uint32)
+   *   levels   width, height, tiles x, tiles y, index of the level's first tile (5 x uint32)
+   *   tiles    every tile of every level, tile size squared RGBA8 texels each, in 4x4 blocks.
+   *            Tiles on a level's right and bottom edges are padded.
+   */
+  class TiledImage {
+  public:
+    static constexpr int defaultTileSize = 64;
+
+    // Returns nullptr if the file can't be opened or isn't a tiled image
+    static sPtr<TiledImage> Open(std::string const &path);
+
+    // Builds the mip chain of `image` and writes it as a tiled image. Returns false on failure.
+    static bool Write(Image const &image, std::string const &path, int tileSize = defaultTileSize);
+
+    ~TiledImage();
+
+    TiledImage(TiledImage const &)            = delete;
+    TiledImage &operator=(TiledImage const &) = delete;
+
+    int width() const { return levels[0].width; }
+    int height() const { return levels[0].height; }
+    int levelCount() const { return levels.size(); }
+
+    // Same lookups as MipPyramid, in 0-255 per channel
+    vec3  Bilinear(int level, float u, float v, bool wrapU = false) const;
+    vec3  Trilinear(float u, float v, float lod, bool wrapU = false) const;
+    float Lod(float footprint) const;
+
+  private:
+    struct Level {
+      std::uint32_t width, height, tilesX, tilesY, firstTile;
+    };
+
+    TiledImage() = default;
+
+    Texel8 Fetch(int level, int x, int y) const;
+
+    sPtr<const TextureTile> LoadTile(std::uint64_t tileIndex) const;
+
+    std::uint32_t      id; // Distinguishes this image's tiles in the shared cache, wraps after 2^20 opens
+    int                fd = -1;
+    int                tileSize;
+    std::uint64_t      dataOffset;
+    std::vector<Level> levels;
+  };
+} // namespace rt
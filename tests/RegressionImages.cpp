@@ -0,0 +1,303 @@
+#include "../bench/SceneRuns.h"
+
+#include "Util.h"
+#include "output/ImageError.h"
+#include "output/ImageOutput.h"
+
+#include <argumentum/argparse.h>
+#include <nlohmann-json/json.hpp>
+#include <raylib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Renders tiny versions of the built-in and saved scenes and compares them with the references
+// in tests/references, so changes to the BVH, sampling or math can't change the images
+// unnoticed. Exits with 77 (skipped) if no render fails but some references are missing.
+//
+// Another compiler or its flags (-ffast-math, -march=native) can round differently, change the
+// number of random numbers a path takes and so the noise of the rest of its tile. Renders are
+// allowed twice the errors between the reference and renders with other seeds, which are saved
+// with the references as noise.json: the FLIP-like error, for changes in parts of the image, and
+// the difference of the mean luminance, for changes of the brightness of all of it. Dark scenes
+// are noisy, their references are rendered with more samples until a 5% change of brightness is
+// well above the mean's allowed error.
+//
+// Usage: regression_images [--update] [--references DIR] [--threads N]
+// After a change that's meant to alter the images, check them and run with --update to render
+// the references again.
+
+using namespace rt;
+using namespace rt::bench;
+using namespace argumentum;
+using json = nlohmann::json;
+
+namespace {
+  constexpr int           size               = 64;
+  constexpr int           samplesPerPixel    = 32; // Of scenes that aren't too noisy
+  constexpr int           maxSamplesPerPixel = 1024;
+  constexpr std::uint32_t seed               = 0;
+
+  // Images are compared as averages of blocks of pixels, which keeps changes of brightness or
+  // color but averages most of the noise out
+  constexpr int blockSize = 8;
+
+  // Allowed errors, relative to the reference's noise. The floor covers scenes without noise,
+  // which only differ by rounding.
+  constexpr double noiseFactor = 2;
+  constexpr double minError    = 1e-4;
+
+  // Renders with other seeds the noise is measured with, the errors of a single one can be half
+  // of another's
+  constexpr int noiseSeeds = 4;
+
+  // Uniform changes of brightness this large have to fail in every scene, with a margin of 2
+  constexpr double detectedBrightness = 0.05;
+
+  constexpr int skipReturnCode = 77;
+
+  struct Options {
+    bool        update     = false;
+    std::string references = "tests/references";
+    int         threads    = int(std::max(1u, std::thread::hardware_concurrency()));
+  };
+
+  struct Deviation {
+    double flipLike; // Of the downsampled images
+    double mean;     // Relative difference of the mean luminance
+  };
+
+  struct TestScene {
+    std::string                    name; // Also the reference's file name
+    std::function<Scene(int, int)> build;
+  };
+
+  // "Random Moving" -> "builtin_random_moving"
+  std::string ReferenceName(std::string const &prefix, std::string const &name) {
+    std::string result = prefix + "_";
+    for (char c : name) {
+      result += std::isalnum(static_cast<unsigned char>(c)) ? char(std::tolower(static_cast<unsigned char>(c))) : '_';
+    }
+
+    return result;
+  }
+
+  std::vector<TestScene> TestScenes() {
+    std::vector<TestScene> scenes;
+    for (auto const &[name, build] : Scene::builtInScenes) {
+      scenes.push_back({ReferenceName("builtin", name), build});
+    }
+
+    for (auto const &path : SceneFiles()) {
+      scenes.push_back({ReferenceName("scene", std::filesystem::path(path).stem().string()),
+                        [path](int width, int height) { return Scene::Load(width, height, path); }});
+    }
+
+    return scenes;
+  }
+
+  // Beauty pass with each `blockSize`^2 block of pixels averaged into one
+  OutputImage Downsampled(OutputImage const &image) {
+    OutputImage result;
+    result.width  = image.width / blockSize;
+    result.height = image.height / blockSize;
+
+    auto const &data = image.layers.front().data;
+    ImageLayer  layer{"", {"R", "G", "B"}, std::vector<float>(std::size_t(result.width) * result.height * 3)};
+    for (int y = 0; y < result.height * blockSize; y++) {
+      for (int x = 0; x < result.width * blockSize; x++) {
+        for (int c = 0; c < 3; c++) {
+          layer.data[(std::size_t(y / blockSize) * result.width + x / blockSize) * 3 + c] +=
+              data[(std::size_t(y) * image.width + x) * 3 + c] / (blockSize * blockSize);
+        }
+      }
+    }
+
+    result.layers.push_back(std::move(layer));
+    return result;
+  }
+
+  double MeanLuminance(OutputImage const &image) {
+    auto const &data = image.layers.front().data;
+
+    double sum = 0;
+    for (std::size_t i = 0; i + 2 < data.size(); i += 3) {
+      sum += 0.2126 * data[i] + 0.7152 * data[i + 1] + 0.0722 * data[i + 2];
+    }
+
+    return sum / std::max<std::size_t>(data.size() / 3, 1);
+  }
+
+  // Nothing if the images' sizes differ
+  std::optional<Deviation> Compare(OutputImage const &image, OutputImage const &reference) {
+    auto const error = CompareImages(Downsampled(image), Downsampled(reference));
+    if (!error)
+      return std::nullopt;
+
+    double const expected = MeanLuminance(reference);
+    return Deviation{error->flipLike, std::abs(MeanLuminance(image) - expected) / std::max(expected, 1e-6)};
+  }
+
+  OutputImage Render(TestScene const &test, RenderPool &pool, int threads, int spp, std::uint32_t renderSeed) {
+    // Random scenes are generated from the calling thread's sequence, keep them the same
+    SeedRandom(seed);
+
+    Scene scene                    = test.build(size, size);
+    scene.settings.samplesPerPixel = spp;
+    scene.settings.seed            = renderSeed;
+
+    AsyncRenderData ard(size, size, size, size, threads);
+    ard.changeNumThreads(threads, pool.numNodes());
+    ard.setTraversalOrder(scene.settings.traversalOrder);
+    RenderOnce(scene, ard, pool);
+
+    return Snapshot(ard.frameBuffer);
+  }
+
+  // Largest errors of renders with other seeds against `image`
+  Deviation MeasureNoise(TestScene const &test, OutputImage const &image, RenderPool &pool, int threads, int spp) {
+    Deviation noise{0, 0};
+    for (std::uint32_t other = seed + 1; other <= seed + noiseSeeds; other++) {
+      auto const error = Compare(Render(test, pool, threads, spp, other), image);
+      noise.flipLike   = std::max(noise.flipLike, error->flipLike);
+      noise.mean       = std::max(noise.mean, error->mean);
+    }
+
+    return noise;
+  }
+
+  // Above 1 if the mean's allowed error is more than half of `detectedBrightness`
+  double NoiseExcess(Deviation const &noise) { return noiseFactor * noise.mean / (detectedBrightness / 2); }
+} // namespace
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+
+  Options         options;
+  argument_parser parser;
+
+  parser.config().program(argv[0]).description("Compares tiny renders of every scene with their references");
+  parser.add_argument(options.update, "--update").nargs(0).absent(false).help("Render the references again instead of comparing");
+  parser.add_argument(options.references, "--references")
+      .maxargs(1)
+      .absent(options.references)
+      .help("Directory of the reference images");
+  parser.add_argument(options.threads, "--threads").maxargs(1).absent(options.threads).help("Render threads");
+
+  if (!parser.parse_args(argc, argv, 1))
+    return 1;
+
+  options.threads = std::max(options.threads, 1);
+
+  StdoutToStderr logs;
+  auto const     scenes = TestScenes();
+
+  RenderPool pool(options.threads);
+  int        failed = 0, missing = 0;
+
+  std::string const noisePath = (std::filesystem::path(options.references) / "noise.json").string();
+
+  json noise = json::object();
+  if (options.update) {
+    std::filesystem::create_directories(options.references);
+  } else if (std::ifstream file(noisePath); file) {
+    noise = json::parse(file, nullptr, false);
+    if (!noise.is_object()) {
+      std::cerr << "Failed to parse " << noisePath << '\n';
+      noise = json::object();
+    }
+  }
+
+  for (auto const &test : scenes) {
+    std::string const path = (std::filesystem::path(options.references) / (test.name + ".pfm")).string();
+
+    if (options.update) {
+      int         spp   = samplesPerPixel;
+      OutputImage image = Render(test, pool, options.threads, spp, seed);
+      Deviation   error = MeasureNoise(test, image, pool, options.threads, spp);
+
+      // The noise of the mean falls with the square root of the samples. It's measured again
+      // after each step, the estimate of a few seeds is noisy too.
+      for (double excess = NoiseExcess(error); excess > 1 && spp < maxSamplesPerPixel; excess = NoiseExcess(error)) {
+        int const previousSpp = spp;
+        while (spp < maxSamplesPerPixel && spp < previousSpp * excess * excess) {
+          spp *= 2;
+        }
+
+        image = Render(test, pool, options.threads, spp, seed);
+        error = MeasureNoise(test, image, pool, options.threads, spp);
+      }
+
+      if (NoiseExcess(error) > 1)
+        std::cerr << "WARNING: " << test.name << " is too noisy at " << spp
+                  << " spp to notice every change of brightness of " << detectedBrightness * 100 << "%\n";
+
+      if (WritePFM(path, image)) {
+        noise[test.name] = {{"samples_per_pixel", spp}, {"flip_like", error.flipLike}, {"mean", error.mean}};
+        logs.results << "UPDATED " << test.name << ": " << spp << " spp, flip-like noise " << error.flipLike
+                     << ", mean noise " << error.mean << '\n';
+      } else {
+        logs.results << "FAIL    " << test.name << ": couldn't write " << path << '\n';
+        failed++;
+      }
+      continue;
+    }
+
+    auto const reference = ReadPFM(path);
+    if (!reference || !noise.contains(test.name) || !noise[test.name].is_object()) {
+      logs.results << "MISSING " << test.name << ": no reference at " << path << " or its noise in " << noisePath << '\n';
+      missing++;
+      continue;
+    }
+
+    json const       &sceneNoise = noise[test.name];
+    OutputImage const image =
+        Render(test, pool, options.threads, sceneNoise.value("samples_per_pixel", samplesPerPixel), seed);
+
+    if (auto const error = Compare(image, *reference); !error) {
+      logs.results << "FAIL    " << test.name << ": the reference is " << reference->width << "x"
+                   << reference->height << '\n';
+      failed++;
+    } else {
+      double const maxFlipLike = std::max(noiseFactor * sceneNoise.value("flip_like", 0.0), minError);
+      double const maxMean     = std::max(noiseFactor * sceneNoise.value("mean", 0.0), minError);
+      bool const   passed      = error->flipLike <= maxFlipLike && error->mean <= maxMean;
+
+      char line[256];
+      std::snprintf(line, sizeof(line), "%s %s: flip-like %.5f (max %.5f), mean %.5f (max %.5f)\n",
+                    passed ? "PASS   " : "FAIL   ", test.name.c_str(), error->flipLike, maxFlipLike, error->mean,
+                    maxMean);
+      logs.results << line;
+      failed += passed ? 0 : 1;
+    }
+  }
+
+  if (options.update) {
+    std::ofstream file(noisePath);
+    file << noise.dump(2) << '\n';
+    if (!file) {
+      std::cerr << "Failed to write " << noisePath << '\n';
+      return 1;
+    }
+
+    return failed > 0 ? 1 : 0;
+  }
+
+  logs.results << scenes.size() - failed - missing << " passed, " << failed << " failed, " << missing << " missing\n";
+
+  if (failed > 0)
+    return 1;
+
+  return missing > 0 ? skipReturnCode : 0;
+}